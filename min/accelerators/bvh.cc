@@ -1,5 +1,8 @@
 #include "bvh.h"
 #include <min/visual/shape.h>
+#include <min/shapes/triangle.h>
+#include <min/common/cpu.h>
+#include <min/common/memory.h>
 
 namespace min {
 
@@ -46,7 +49,8 @@ struct LBVHTreelet {
 };
 
 struct LinearBVHNode {
-  Bounds3f bounds;
+  // Corners as plain floats, a padded Bounds3f would not fit the node in half a cache line
+  Float bounds[2][3];
   union {
     int primitivesOffset;   // leaf
     int secondChildOffset;  // interior
@@ -54,7 +58,100 @@ struct LinearBVHNode {
   uint16_t nPrimitives;  // 0 -> interior node
   uint8_t axis;          // interior node: xyz
   uint8_t pad[1];        // ensure 32 byte total size
+
+  Bounds3f Bounds() const {
+    return Bounds3f(Point3f(bounds[0][0], bounds[0][1], bounds[0][2]),
+                    Point3f(bounds[1][0], bounds[1][1], bounds[1][2]));
+  }
 };
+static_assert(sizeof(Float) != 4 || sizeof(LinearBVHNode) == 32, "LinearBVHNode should fill half a cache line");
+
+// Slab test of Bounds3::IntersectP on the node corners
+MIN_FORCE_INLINE bool IntersectNode(const LinearBVHNode &node, const Ray &ray, const Vector3f &invDir,
+                                    const int dirIsNeg[3]) {
+  Float tMin = (node.bounds[dirIsNeg[0]][0] - ray.o.x) * invDir.x;
+  Float tMax = (node.bounds[1 - dirIsNeg[0]][0] - ray.o.x) * invDir.x;
+  Float tyMin = (node.bounds[dirIsNeg[1]][1] - ray.o.y) * invDir.y;
+  Float tyMax = (node.bounds[1 - dirIsNeg[1]][1] - ray.o.y) * invDir.y;
+  tMax *= 1 + 2 * Gamma(3);
+  tyMax *= 1 + 2 * Gamma(3);
+  if (tMin > tyMax || tyMin > tMax) return false;
+  if (tyMin > tMin) tMin = tyMin;
+  if (tyMax < tMax) tMax = tyMax;
+  Float tzMin = (node.bounds[dirIsNeg[2]][2] - ray.o.z) * invDir.z;
+  Float tzMax = (node.bounds[1 - dirIsNeg[2]][2] - ray.o.z) * invDir.z;
+  tzMax *= 1 + 2 * Gamma(3);
+  if (tMin > tzMax || tzMin > tMax) return false;
+  if (tzMin > tMin) tMin = tzMin;
+  if (tzMax < tMax) tMax = tzMax;
+  return (tMin < ray.tmax) && (tMax > 0);
+}
+
+// Closest hit when isect is given, any hit otherwise. Triangles are tested inline and only the closest
+// one fills isect, other shapes go through Shape::Intersect
+template <bool kAnyHit>
+MIN_FORCE_INLINE bool Traverse(const LinearBVHNode *nodes, const std::shared_ptr<Shape> *primitives,
+                               const Triangle *const *triangles, const Ray &ray, SurfaceIntersection *isect) {
+  bool hit = false;
+  const Triangle *closest = nullptr;
+  Float closest_b[3];
+  Vector3f invDir(1 / ray.d.x, 1 / ray.d.y, 1 / ray.d.z);
+  int dirIsNeg[3] = {invDir.x < 0, invDir.y < 0, invDir.z < 0};
+  // Follow ray through BVH nodes to find primitive intersections
+  int toVisitOffset = 0, currentNodeIndex = 0;
+  int nodesToVisit[64];
+  while (true) {
+    const LinearBVHNode *node = &nodes[currentNodeIndex];
+    // Check ray against BVH node
+    if (IntersectNode(*node, ray, invDir, dirIsNeg)) {
+      if (node->nPrimitives > 0) {
+        // Intersect ray with primitives in leaf BVH node
+        for (int i = 0; i < node->nPrimitives; ++i) {
+          int index = node->primitivesOffset + i;
+          if (const Triangle *triangle = triangles[index]) {
+            Float t, b[3];
+            if (!WatertightIntersect(triangle->Vertex(0), triangle->Vertex(1), triangle->Vertex(2), ray, &t, b))
+              continue;
+            if (kAnyHit) return true;
+            ray.tmax = t;
+            closest = triangle;
+            std::copy(b, b + 3, closest_b);
+            hit = true;
+          } else if (kAnyHit) {
+            if (primitives[index]->IntersectP(ray)) return true;
+          } else if (primitives[index]->Intersect(ray, *isect)) {
+            closest = nullptr;
+            hit = true;
+          }
+        }
+        if (toVisitOffset == 0) break;
+        currentNodeIndex = nodesToVisit[--toVisitOffset];
+      } else {
+        // Put far BVH node on _nodesToVisit_ stack, advance to near
+        // node
+        if (dirIsNeg[node->axis]) {
+          nodesToVisit[toVisitOffset++] = currentNodeIndex + 1;
+          currentNodeIndex = node->secondChildOffset;
+        } else {
+          nodesToVisit[toVisitOffset++] = node->secondChildOffset;
+          currentNodeIndex = currentNodeIndex + 1;
+        }
+      }
+    } else {
+      if (toVisitOffset == 0) break;
+      currentNodeIndex = nodesToVisit[--toVisitOffset];
+    }
+  }
+  if (closest) closest->FillIntersection(ray, ray.tmax, closest_b, *isect);
+  return hit;
+}
+
+MIN_CPU_KERNEL(bool, TraverseClosest, (const LinearBVHNode *nodes, const std::shared_ptr<Shape> *primitives,
+    const Triangle *const *triangles, const Ray &ray, SurfaceIntersection *isect),
+    Traverse<false>(nodes, primitives, triangles, ray, isect))
+
+MIN_CPU_KERNEL(bool, TraverseAny, (const LinearBVHNode *nodes, const std::shared_ptr<Shape> *primitives,
+    const Triangle *const *triangles, const Ray &ray), Traverse<true>(nodes, primitives, triangles, ray, nullptr))
 
 // BVHAccel Utility Functions
 inline uint32_t LeftShift3(uint32_t x) {
@@ -138,7 +235,7 @@ struct BucketInfo {
 };
 
 Bounds3f BVHAccel::WorldBound() const {
-  return nodes ? nodes[0].bounds : Bounds3f();;
+  return nodes ? nodes[0].Bounds() : Bounds3f();
 }
 
 BVHBuildNode *BVHAccel::recursiveBuild(std::vector<BVHPrimitiveInfo> &primitiveInfo,
@@ -544,7 +641,10 @@ BVHBuildNode *BVHAccel::buildUpperSAH(std::vector<BVHBuildNode *> &treeletRoots,
 }
 int BVHAccel::flattenBVHTree(BVHBuildNode *node, int *offset) {
   LinearBVHNode *linearNode = &nodes[*offset];
-  linearNode->bounds = node->bounds;
+  for (int i = 0; i < 3; ++i) {
+    linearNode->bounds[0][i] = node->bounds.pmin[i];
+    linearNode->bounds[1][i] = node->bounds.pmax[i];
+  }
   int myOffset = (*offset)++;
   if (node->nPrimitives > 0) {
     MIN_ASSERT(!node->children[0] && !node->children[1]);
@@ -564,83 +664,19 @@ int BVHAccel::flattenBVHTree(BVHBuildNode *node, int *offset) {
 
 
 BVHAccel::~BVHAccel() {
-  free(nodes);
+  FreeAligned(nodes);
 }
 
 bool BVHAccel::Intersect(const Ray &ray, SurfaceIntersection &isect) const {
   if (!nodes) return false;
-  bool hit = false;
-  Vector3f invDir(1 / ray.d.x, 1 / ray.d.y, 1 / ray.d.z);
-  int dirIsNeg[3] = {invDir.x < 0, invDir.y < 0, invDir.z < 0};
-  // Follow ray through BVH nodes to find primitive intersections
-  int toVisitOffset = 0, currentNodeIndex = 0;
-  int nodesToVisit[64];
-  while (true) {
-    const LinearBVHNode *node = &nodes[currentNodeIndex];
-    // Check ray against BVH node
-    if (node->bounds.IntersectP(ray, invDir, dirIsNeg)) {
-      if (node->nPrimitives > 0) {
-        // Intersect ray with primitives in leaf BVH node
-        for (int i = 0; i < node->nPrimitives; ++i)
-          if (primitives[node->primitivesOffset + i]->Intersect(
-              ray, isect))
-            hit = true;
-        if (toVisitOffset == 0) break;
-        currentNodeIndex = nodesToVisit[--toVisitOffset];
-      } else {
-        // Put far BVH node on _nodesToVisit_ stack, advance to near
-        // node
-        if (dirIsNeg[node->axis]) {
-          nodesToVisit[toVisitOffset++] = currentNodeIndex + 1;
-          currentNodeIndex = node->secondChildOffset;
-        } else {
-          nodesToVisit[toVisitOffset++] = node->secondChildOffset;
-          currentNodeIndex = currentNodeIndex + 1;
-        }
-      }
-    } else {
-      if (toVisitOffset == 0) break;
-      currentNodeIndex = nodesToVisit[--toVisitOffset];
-    }
-  }
-  return hit;
+  static const auto traverse = MIN_CPU_DISPATCH(TraverseClosest);
+  return traverse(nodes, primitives.data(), triangles.data(), ray, &isect);
 }
 
 bool BVHAccel::IntersectP(const Ray &ray) const {
   if (!nodes) return false;
-  Vector3f invDir(1 / ray.d.x, 1 / ray.d.y, 1 / ray.d.z);
-  int dirIsNeg[3] = {invDir.x < 0, invDir.y < 0, invDir.z < 0};
-  // Follow ray through BVH nodes to find primitive intersections
-  int toVisitOffset = 0, currentNodeIndex = 0;
-  int nodesToVisit[64];
-  while (true) {
-    const LinearBVHNode *node = &nodes[currentNodeIndex];
-    // Check ray against BVH node
-    if (node->bounds.IntersectP(ray, invDir, dirIsNeg)) {
-      if (node->nPrimitives > 0) {
-        // Intersect ray with primitives in leaf BVH node
-        for (int i = 0; i < node->nPrimitives; ++i)
-          if (primitives[node->primitivesOffset + i]->IntersectP(
-              ray)) return true;
-        if (toVisitOffset == 0) break;
-        currentNodeIndex = nodesToVisit[--toVisitOffset];
-      } else {
-        // Put far BVH node on _nodesToVisit_ stack, advance to near
-        // node
-        if (dirIsNeg[node->axis]) {
-          nodesToVisit[toVisitOffset++] = currentNodeIndex + 1;
-          currentNodeIndex = node->secondChildOffset;
-        } else {
-          nodesToVisit[toVisitOffset++] = node->secondChildOffset;
-          currentNodeIndex = currentNodeIndex + 1;
-        }
-      }
-    } else {
-      if (toVisitOffset == 0) break;
-      currentNodeIndex = nodesToVisit[--toVisitOffset];
-    }
-  }
-  return false;
+  static const auto traverse = MIN_CPU_DISPATCH(TraverseAny);
+  return traverse(nodes, primitives.data(), triangles.data(), ray);
 }
 
 void BVHAccel::AddShape(const std::vector<std::shared_ptr<Shape>> &shape) {
@@ -668,9 +704,14 @@ void BVHAccel::Build() {
                           &totalNodes, orderedPrims);
   primitives.swap(orderedPrims);
   primitiveInfo.resize(0);
+  triangles.resize(primitives.size());
+  for (size_t i = 0; i < primitives.size(); ++i) {
+    auto triangle = dynamic_cast<const Triangle *>(primitives[i].get());
+    triangles[i] = triangle && !triangle->Degenerate() ? triangle : nullptr;
+  }
   MIN_INFO("BVH created with {} nodes for {}", totalNodes, (int)primitives.size());
 
-  nodes = new LinearBVHNode[totalNodes];
+  nodes = AllocAligned<LinearBVHNode>(totalNodes);
   int offset = 0;
   flattenBVHTree(root, &offset);
   MIN_ASSERT(totalNodes == offset);
@@ -10,6 +10,7 @@ struct BVHBuildNode;
 struct BVHPrimitiveInfo;
 struct MortonPrimitive;
 struct LinearBVHNode;
+class Triangle;
 
 // BVHAccel Declarations
 class BVHAccel : public Accelerator {
@@ -47,6 +48,8 @@ class BVHAccel : public Accelerator {
   int maxPrimsInNode;
   SplitMethod splitMethod;
   std::vector<std::shared_ptr<Shape>> primitives;
+  // Per primitive, the triangle tested inline during traversal or nullptr for the virtual Shape path
+  std::vector<const Triangle *> triangles;
   LinearBVHNode *nodes = nullptr;
 };
 
@@ -5,7 +5,16 @@ namespace min {
 class PerspectiveCamera : public Camera {
   Transform camera2screen, raster2camera;
   Transform screen2raster, raster2screen;
+  Vector3f dx_camera, dy_camera;
+  // Film origin direction and per raster pixel steps in world space, a ray direction is then
+  // Normalize(d_world + x * dx_world + y * dy_world) for raster position (x, y)
+  Point3f origin_world;
+  Vector3f d_world, dx_world, dy_world;
   Float fov;
+
+  MIN_FORCE_INLINE Vector3f RasterToWorld(const Point2f &pfilm) const {
+    return d_world + pfilm.x * dx_world + pfilm.y * dy_world;
+  }
  public:
   void initialize(const Json &json) override {
     fov = Value(json, "fov", 90.f);
@@ -25,15 +34,39 @@ class PerspectiveCamera : public Camera {
         Translate(Vector3f(-screen_window.pmin.x, -screen_window.pmax.y, 0));
     raster2screen = Inverse(screen2raster);
     raster2camera = Inverse(camera2screen) * raster2screen;
+    dx_camera = raster2camera.ToPoint(Point3f(1, 0, 0)) - raster2camera.ToPoint(Point3f(0, 0, 0));
+    dy_camera = raster2camera.ToPoint(Point3f(0, 1, 0)) - raster2camera.ToPoint(Point3f(0, 0, 0));
+    // The film lies on the near plane, so camera space positions are affine in raster x and y
+    origin_world = camera2world.ToPoint(Point3f(0, 0, 0));
+    d_world = camera2world.ToVector(Vector3f(raster2camera.ToPoint(Point3f(0, 0, 0))));
+    dx_world = camera2world.ToVector(dx_camera);
+    dy_world = camera2world.ToVector(dy_camera);
   }
   Float GenerateRay(const Point2f &pfilm, const Point2f &plens, Float time, Ray &ray) const override {
-    Point3f pcamera = raster2camera.ToPoint(Point3f(pfilm.x, pfilm.y, 0));
-    ray = Ray(Point3f(0, 0, 0), Normalize(pcamera));
+    ray = Ray(origin_world, Normalize(RasterToWorld(pfilm)));
+    ray.time = time;
+    return 1;
+  }
+  Float GenerateRayDifferential(const Point2f &pfilm, const Point2f &plens, Float time,
+                                RayDifferential &ray) const override {
+    Vector3f d = RasterToWorld(pfilm);
+    ray = RayDifferential(origin_world, Normalize(d));
     ray.time = time;
-    ray.o = camera2world.ToPoint(ray.o);
-    ray.d = camera2world.ToVector(ray.d);
+    ray.rx_origin = ray.ry_origin = ray.o;
+    ray.rx_direction = Normalize(d + dx_world);
+    ray.ry_direction = Normalize(d + dy_world);
+    ray.has_differentials = true;
     return 1;
   }
+  void GenerateRays(const CameraSample *samples, int n, CameraRays &rays) const override {
+    rays.Resize(n);
+    Float *const dir[3] = {rays.dx, rays.dy, rays.dz};
+    PinholeDirections(samples, n, d_world, dx_world, dy_world, dir, rays.time);
+    std::fill(rays.ox, rays.ox + n, origin_world.x);
+    std::fill(rays.oy, rays.oy + n, origin_world.y);
+    std::fill(rays.oz, rays.oz + n, origin_world.z);
+    std::fill(rays.weight, rays.weight + n, Float(1));
+  }
 };
 MIN_IMPLEMENTATION(Camera, PerspectiveCamera, "perspective")
 
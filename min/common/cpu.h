@@ -0,0 +1,58 @@
+#pragma once
+
+#include "util.h"
+#include <string>
+
+namespace min {
+
+// Instruction set levels the hot kernels are built for, ordered. AVX-512 hosts run the AVX2 kernels
+enum class CpuTarget { kBaseline, kAVX2 };
+
+struct CpuFeatures {
+  std::string brand;
+  bool sse41 = false, avx = false, fma = false, avx2 = false, bmi2 = false;
+
+  // Best target that both the processor and the OS (register state saving) support
+  CpuTarget MaxTarget() const {
+    if (avx2 && fma && bmi2) return CpuTarget::kAVX2;
+    return CpuTarget::kBaseline;
+  }
+};
+
+const CpuFeatures &GetCpuFeatures();
+
+const char *CpuTargetName(CpuTarget target);
+
+// Chooses the kernel variants for this process from "auto", "baseline" or "avx2", the
+// MIN_CPU_TARGET environment variable takes precedence. Kernels resolve their variant on first use,
+// so this must run before rendering starts
+void SelectCpuTarget(const std::string &request = "auto");
+
+// Selects "auto" if SelectCpuTarget was never called
+CpuTarget GetCpuTarget();
+
+template <typename F>
+F SelectCpuVariant(F baseline, F avx2) {
+  switch (GetCpuTarget()) {
+    case CpuTarget::kAVX2: return avx2;
+    default: return baseline;
+  }
+}
+
+}
+
+// Per function code generation, callees forced inline are compiled for the target of the variant
+// while out of line copies stay baseline. MSVC has no equivalent, build with clang-cl to get variants
+#if (defined(__GNUC__) || defined(__clang__)) && (defined(__x86_64__) || defined(__i386__))
+#define MIN_TARGET_AVX2 __attribute__((target("avx2,fma,bmi,bmi2")))
+#else
+#define MIN_TARGET_AVX2
+#endif
+
+// Defines name##Baseline and name##AVX2 returning call, which should only reach
+// MIN_FORCE_INLINE code for the variants to differ. params may carry a trailing const for members
+#define MIN_CPU_KERNEL(ret, name, params, call)            \
+  inline ret name##Baseline params { return call; }        \
+  MIN_TARGET_AVX2 inline ret name##AVX2 params { return call; }
+
+#define MIN_CPU_DISPATCH(name) ::min::SelectCpuVariant(name##Baseline, name##AVX2)
@@ -1,9 +1,15 @@
 #pragma once
 
 #include <cstddef>
+#include <cstdint>
+#include <list>
+#include <new>
+#include <utility>
 
 namespace min {
 
+#define MIN_ARENA_ALLOC(arena, Type) new ((arena).Alloc(sizeof(Type))) Type
+
 void *AllocAligned_(size_t size);
 template <typename T>
 T *AllocAligned(size_t count) {
@@ -12,6 +18,48 @@ T *AllocAligned(size_t count) {
 
 void FreeAligned(void *ptr);
 
-}
+// Bump allocator for short-lived per-sample objects, Reset() recycles every block at once.
+// Destructors of arena objects never run, so only trivially destructible data belongs here.
+class alignas(64) MemoryArena {
+ public:
+  explicit MemoryArena(size_t block_size = 262144) : block_size(block_size) {}
+  MemoryArena(const MemoryArena &) = delete;
+  MemoryArena &operator=(const MemoryArena &) = delete;
+  ~MemoryArena();
+
+  void *Alloc(size_t n_bytes) {
+    // Keep every allocation 16-byte aligned
+    const int align = alignof(std::max_align_t);
+    n_bytes = (n_bytes + align - 1) & ~(align - 1);
+    if (current_block_pos + n_bytes > current_alloc_size) NextBlock(n_bytes);
+    void *ret = current_block + current_block_pos;
+    current_block_pos += n_bytes;
+    return ret;
+  }
+
+  template <typename T>
+  T *Alloc(size_t n = 1, bool run_constructor = true) {
+    T *ret = (T *)Alloc(n * sizeof(T));
+    if (run_constructor)
+      for (size_t i = 0; i < n; ++i) new (&ret[i]) T();
+    return ret;
+  }
+
+  void Reset() {
+    current_block_pos = 0;
+    available_blocks.splice(available_blocks.begin(), used_blocks);
+  }
 
+  size_t TotalAllocated() const;
+
+ private:
+  void NextBlock(size_t n_bytes);
+
+  const size_t block_size;
+  size_t current_block_pos = 0, current_alloc_size = 0;
+  uint8_t *current_block = nullptr;
+  std::list<std::pair<size_t, uint8_t *>> used_blocks, available_blocks;
+};
+
+}
 
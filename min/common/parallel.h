@@ -2,6 +2,8 @@
 
 #include "util.h"
 #include <min/math/math.h>
+#include <atomic>
+#include <cstring>
 
 namespace min {
 
@@ -9,6 +11,35 @@ void ParallelFor(std::function<void(int64_t)> func, int64_t count);
 
 void ParallelFor2D(std::function<void(Vector2i)> func, const Vector2i &count);
 
-}
+// Float that supports lock-free accumulation from multiple threads
+class AtomicFloat {
+  using Bits = std::conditional_t<sizeof(Float) == 4, uint32_t, uint64_t>;
+  std::atomic<Bits> bits;
+
+  static Bits ToBits(Float v) {
+    Bits b;
+    std::memcpy(&b, &v, sizeof(Float));
+    return b;
+  }
+  static Float FromBits(Bits b) {
+    Float v;
+    std::memcpy(&v, &b, sizeof(Float));
+    return v;
+  }
+ public:
+  explicit AtomicFloat(Float v = 0) { bits = ToBits(v); }
+  operator Float() const { return FromBits(bits); }
+  Float operator=(Float v) {
+    bits = ToBits(v);
+    return v;
+  }
+  void Add(Float v) {
+    Bits old_bits = bits, new_bits;
+    do {
+      new_bits = ToBits(FromBits(old_bits) + v);
+    } while (!bits.compare_exchange_weak(old_bits, new_bits));
+  }
+};
 
+}
 
@@ -0,0 +1,117 @@
+#include <min/common/cpu.h>
+#include <atomic>
+#include <mutex>
+#if defined(_MSC_VER)
+#include <intrin.h>
+#elif defined(__x86_64__) || defined(__i386__)
+#include <cpuid.h>
+#endif
+
+namespace min {
+
+namespace {
+
+#if defined(_MSC_VER) || defined(__x86_64__) || defined(__i386__)
+#define MIN_HAS_CPUID
+
+void Cpuid(uint32_t leaf, uint32_t subleaf, uint32_t regs[4]) {
+#if defined(_MSC_VER)
+  int r[4];
+  __cpuidex(r, int(leaf), int(subleaf));
+  for (int i = 0; i < 4; ++i) regs[i] = uint32_t(r[i]);
+#else
+  __cpuid_count(leaf, subleaf, regs[0], regs[1], regs[2], regs[3]);
+#endif
+}
+
+// Register state the OS saves on context switches
+uint64_t Xgetbv() {
+#if defined(_MSC_VER)
+  return _xgetbv(0);
+#else
+  uint32_t eax, edx;
+  __asm__ volatile("xgetbv" : "=a"(eax), "=d"(edx) : "c"(0));
+  return (uint64_t(edx) << 32U) | eax;
+#endif
+}
+#endif
+
+CpuFeatures DetectCpuFeatures() {
+  CpuFeatures f;
+#if defined(MIN_HAS_CPUID)
+  uint32_t regs[4];
+  Cpuid(0, 0, regs);
+  uint32_t max_leaf = regs[0];
+  Cpuid(0x80000000U, 0, regs);
+  if (regs[0] >= 0x80000004U) {
+    char brand[49] = {};
+    for (uint32_t i = 0; i < 3; ++i) {
+      Cpuid(0x80000002U + i, 0, regs);
+      std::memcpy(brand + 16 * i, regs, 16);
+    }
+    f.brand = brand;
+    f.brand.erase(0, f.brand.find_first_not_of(' '));
+  }
+  if (max_leaf < 1) return f;
+  Cpuid(1, 0, regs);
+  f.sse41 = regs[2] & (1U << 19U);
+  bool osxsave = regs[2] & (1U << 27U);
+  uint64_t xcr0 = osxsave ? Xgetbv() : 0;
+  // SSE and AVX state
+  bool ymm_state = (xcr0 & 0x6U) == 0x6U;
+  f.avx = ymm_state && (regs[2] & (1U << 28U));
+  f.fma = f.avx && (regs[2] & (1U << 12U));
+  if (max_leaf < 7) return f;
+  Cpuid(7, 0, regs);
+  f.avx2 = f.avx && (regs[1] & (1U << 5U));
+  f.bmi2 = (regs[1] & (1U << 3U)) && (regs[1] & (1U << 8U));
+#endif
+  return f;
+}
+
+std::atomic<int> selected_target{-1};
+std::once_flag auto_select;
+
+}
+
+const CpuFeatures &GetCpuFeatures() {
+  static const CpuFeatures features = DetectCpuFeatures();
+  return features;
+}
+
+const char *CpuTargetName(CpuTarget target) {
+  switch (target) {
+    case CpuTarget::kAVX2: return "avx2";
+    default: return "baseline";
+  }
+}
+
+void SelectCpuTarget(const std::string &request) {
+  const CpuFeatures &features = GetCpuFeatures();
+  CpuTarget max_target = features.MaxTarget();
+  std::string name = request;
+  if (const char *env = std::getenv("MIN_CPU_TARGET")) name = env;
+  CpuTarget target = max_target;
+  if (name != "auto") {
+    if (name == "baseline") target = CpuTarget::kBaseline;
+    else if (name == "avx2") target = CpuTarget::kAVX2;
+    else MIN_WARN("Unknown cpu target \"{}\", using auto", name);
+  }
+  if (target > max_target) {
+    MIN_WARN("Cpu target {} is not supported by this host, using {}", CpuTargetName(target),
+             CpuTargetName(max_target));
+    target = max_target;
+  }
+  selected_target = int(target);
+  MIN_INFO("Cpu \"{}\": running {} kernels (host supports up to {})", features.brand,
+           CpuTargetName(target), CpuTargetName(max_target));
+}
+
+CpuTarget GetCpuTarget() {
+  if (selected_target.load() < 0) std::call_once(auto_select, [] {
+    if (selected_target.load() < 0) SelectCpuTarget("auto");
+  });
+  return CpuTarget(selected_target.load());
+}
+
+}
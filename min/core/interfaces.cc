@@ -10,6 +10,7 @@
 #include <min/visual/material.h>
 #include <min/visual/texture.h>
 #include <min/visual/light.h>
+#include <min/visual/light_sampler.h>
 
 namespace min {
 
@@ -24,5 +25,6 @@ MIN_INTERFACE_DEF(Accelerator, "accelerator")
 MIN_INTERFACE_DEF(Texture, "texture")
 MIN_INTERFACE_DEF(Material, "material")
 MIN_INTERFACE_DEF(Light, "light")
+MIN_INTERFACE_DEF(LightSampler, "light_sampler")
 
 }
\ No newline at end of file
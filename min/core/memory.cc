@@ -1,15 +1,65 @@
 #include <min/common/memory.h>
+#include <min/common/util.h>
+#if defined(MIN_PLATFORM_WINDOWS)
 #include <corecrt_malloc.h>
+#else
+#include <cstdlib>
+#endif
 
 namespace min {
 
 void *AllocAligned_(size_t size) {
+#if defined(MIN_PLATFORM_WINDOWS)
   return _aligned_malloc(size, 64);
+#else
+  void *ptr;
+  if (posix_memalign(&ptr, 64, size) != 0) ptr = nullptr;
+  return ptr;
+#endif
 }
 
 void FreeAligned(void *ptr) {
   if (!ptr) return;
+#if defined(MIN_PLATFORM_WINDOWS)
   _aligned_free(ptr);
+#else
+  free(ptr);
+#endif
+}
+
+MemoryArena::~MemoryArena() {
+  FreeAligned(current_block);
+  for (auto &block : used_blocks) FreeAligned(block.second);
+  for (auto &block : available_blocks) FreeAligned(block.second);
+}
+
+void MemoryArena::NextBlock(size_t n_bytes) {
+  if (current_block) {
+    used_blocks.push_back(std::make_pair(current_alloc_size, current_block));
+    current_block = nullptr;
+    current_alloc_size = 0;
+  }
+  // Reuse a free block that is large enough before asking the system for one
+  for (auto iter = available_blocks.begin(); iter != available_blocks.end(); ++iter) {
+    if (iter->first >= n_bytes) {
+      current_alloc_size = iter->first;
+      current_block = iter->second;
+      available_blocks.erase(iter);
+      break;
+    }
+  }
+  if (!current_block) {
+    current_alloc_size = std::max(n_bytes, block_size);
+    current_block = AllocAligned<uint8_t>(current_alloc_size);
+  }
+  current_block_pos = 0;
+}
+
+size_t MemoryArena::TotalAllocated() const {
+  size_t total = current_alloc_size;
+  for (const auto &alloc : used_blocks) total += alloc.first;
+  for (const auto &alloc : available_blocks) total += alloc.first;
+  return total;
 }
 
 }
@@ -11,6 +11,8 @@ class BoxFilter : public Filter {
   Float Evaluate(const Point2 &p) const override {
     return 1;
   }
+
+  bool IsConstant() const override { return true; }
 };
 MIN_IMPLEMENTATION(Filter, BoxFilter, "box")
 
@@ -0,0 +1,27 @@
+#include <min/visual/filter.h>
+
+namespace min {
+
+class GaussianFilter : public Filter {
+  Float alpha;
+  Float exp_x, exp_y;
+
+  Float Gaussian(Float d, Float expv) const {
+    return std::max((Float)0, Float(std::exp(-alpha * d * d) - expv));
+  }
+ public:
+  void initialize(const Json &json) override {
+    radius = Value(json, "radius", Vector2f(1.5, 1.5));
+    inv_radisu = Vector2f(1 / radius.x, 1 / radius.y);
+    alpha = Value(json, "alpha", 2.0f);
+    exp_x = std::exp(-alpha * radius.x * radius.x);
+    exp_y = std::exp(-alpha * radius.y * radius.y);
+  }
+
+  Float Evaluate(const Point2 &p) const override {
+    return Gaussian(p.x, exp_x) * Gaussian(p.y, exp_y);
+  }
+};
+MIN_IMPLEMENTATION(Filter, GaussianFilter, "gaussian")
+
+}
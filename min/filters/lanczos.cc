@@ -0,0 +1,32 @@
+#include <min/visual/filter.h>
+
+namespace min {
+
+// Sinc filter windowed by a Lanczos sinc of width tau
+class LanczosFilter : public Filter {
+  Float tau;
+
+  static Float Sinc(Float x) {
+    x = std::abs(x);
+    if (x < 1e-5) return 1;
+    return std::sin(kPi * x) / (kPi * x);
+  }
+  Float WindowedSinc(Float x, Float r) const {
+    x = std::abs(x);
+    if (x > r) return 0;
+    return Sinc(x) * Sinc(x / tau);
+  }
+ public:
+  void initialize(const Json &json) override {
+    radius = Value(json, "radius", Vector2f(4, 4));
+    inv_radisu = Vector2f(1 / radius.x, 1 / radius.y);
+    tau = Value(json, "tau", 3.0f);
+  }
+
+  Float Evaluate(const Point2 &p) const override {
+    return WindowedSinc(p.x, radius.x) * WindowedSinc(p.y, radius.y);
+  }
+};
+MIN_IMPLEMENTATION(Filter, LanczosFilter, "lanczos")
+
+}
@@ -0,0 +1,31 @@
+#include <min/visual/filter.h>
+
+namespace min {
+
+class MitchellFilter : public Filter {
+  Float B, C;
+
+  Float Mitchell1D(Float x) const {
+    x = std::abs(2 * x);
+    if (x > 1)
+      return ((-B - 6 * C) * x * x * x + (6 * B + 30 * C) * x * x +
+          (-12 * B - 48 * C) * x + (8 * B + 24 * C)) * (1.f / 6.f);
+    else
+      return ((12 - 9 * B - 6 * C) * x * x * x +
+          (-18 + 12 * B + 6 * C) * x * x + (6 - 2 * B)) * (1.f / 6.f);
+  }
+ public:
+  void initialize(const Json &json) override {
+    radius = Value(json, "radius", Vector2f(2, 2));
+    inv_radisu = Vector2f(1 / radius.x, 1 / radius.y);
+    B = Value(json, "B", 1.f / 3.f);
+    C = Value(json, "C", 1.f / 3.f);
+  }
+
+  Float Evaluate(const Point2 &p) const override {
+    return Mitchell1D(p.x * inv_radisu.x) * Mitchell1D(p.y * inv_radisu.y);
+  }
+};
+MIN_IMPLEMENTATION(Filter, MitchellFilter, "mitchell")
+
+}
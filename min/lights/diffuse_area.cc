@@ -1,18 +1,51 @@
 #include <min/visual/light.h>
 #include <min/visual/shape.h>
+#include <min/visual/distribution.h>
+#include <min/visual/accel.h>
 
 namespace min {
 
+// Emits from every shape it is attached to, a whole emissive mesh shares one light
 class DiffuseAreaLight : public Light {
-  std::shared_ptr<Shape> shape;
+  std::vector<std::shared_ptr<Shape>> shapes;
+  // Picks a shape proportionally to its area so the light samples its surface uniformly
+  AliasTable area_distrib;
+  Float total_area = 0;
+  // Hierarchy over shapes alone, finds the light's own surface along a direction for PdfLi
+  std::shared_ptr<Accelerator> shape_bvh;
   std::shared_ptr<Texture> radiance;
+
+  // Density of a uniformly chosen point on the whole light, measured from ref
+  Float AreaToSolidAngle(const Point3 &ref, const Point3 &p, const Normal3 &n) const {
+    Vector3 wi = p - ref;
+    Float dist2 = wi.LengthSquared();
+    if (dist2 == 0) return 0;
+    Float pdf = dist2 / (AbsDot(n, wi / std::sqrt(dist2)) * total_area);
+    return std::isinf(pdf) ? 0 : pdf;
+  }
  public:
   void initialize(const Json &json) override {
     flags = LightFlags::kArea;
     radiance = CreateInstance<Texture>(json["radiance"]["type"], GetProps(json["radiance"]));
   }
   void SetShape(const std::shared_ptr<Shape> &shape) override {
-    this->shape = shape;
+    SetShapes({shape});
+  }
+  void SetShapes(const std::vector<std::shared_ptr<Shape>> &shapes) override {
+    this->shapes = shapes;
+    std::vector<Float> areas(shapes.size());
+    total_area = 0;
+    for (size_t i = 0; i < shapes.size(); i++) {
+      areas[i] = shapes[i]->Area();
+      total_area += areas[i];
+    }
+    area_distrib = AliasTable(areas.data(), (int)areas.size());
+    shape_bvh = nullptr;
+    if (shapes.size() > 1) {
+      shape_bvh = CreateInstance<Accelerator>("bvh", {});
+      shape_bvh->AddShape(shapes);
+      shape_bvh->Build();
+    }
   }
   void SampleLi(const Point2f &u,
                 const Intersection &isect,
@@ -20,22 +53,54 @@ class DiffuseAreaLight : public Light {
                 VisibilityTester &tester) const override {
     SurfaceSample surface_sample;
     surface_sample.ref = isect.p;
-    shape->Sample(u, surface_sample);
+    if (shapes.size() == 1) {
+      // A lone shape can use its own solid angle sampling
+      shapes[0]->Sample(u, surface_sample);
+    } else {
+      Float u_shape;
+      const Shape *shape = shapes[area_distrib.Sample(u[0], nullptr, &u_shape)].get();
+      shape->SamplePosition(Point2f(u_shape, u[1]), surface_sample);
+      surface_sample.pdf = AreaToSolidAngle(isect.p, surface_sample.p, surface_sample.normal);
+    }
     if (surface_sample.pdf == 0 || (surface_sample.p - isect.p).LengthSquared() == 0) {
       sample.li = Spectrum(0);
       sample.pdf = 0;
       return;
     }
     sample.wi = Normalize(surface_sample.p - isect.p);
-    tester = VisibilityTester(isect, surface_sample.p);
     sample.pdf = surface_sample.pdf;
+    tester = VisibilityTester(isect, surface_sample.p);
     sample.li = Dot(surface_sample.normal, -sample.wi) > 0 ? radiance->Evaluate(isect.sp) : Spectrum(0);
   }
   virtual Spectrum L(const Intersection &isect, const Vector3 &w) const {
     return Dot(isect.geo_frame.n, w) > 0 ? radiance->Evaluate(isect.sp) : Spectrum(0);
   }
+  Spectrum Power() const override {
+    return kPi * radiance->Average() * total_area;
+  }
+  bool Bounds(LightBounds &bounds) const override {
+    // Emits into the hemisphere around each normal, cos_theta_e = cos(pi / 2)
+    Bounds3f world_bound;
+    DirectionCone nb;
+    for (const auto &shape : shapes) {
+      world_bound = Union(world_bound, shape->WorldBound());
+      nb = Union(nb, shape->NormalBounds());
+    }
+    bounds = LightBounds(world_bound, nb.w, Luminance(Power()), nb.cos_theta, 0, false);
+    return true;
+  }
   Float PdfLi(const Intersection &isect, const Vector3 &wi) const override {
-    return shape->Pdf(isect, wi);
+    if (shapes.size() == 1) return shapes[0]->Pdf(isect, wi);
+    if (!shape_bvh) return 0;
+    // Closest point of the light itself along wi, occluders do not change the density. Callers holding
+    // the hit use the SurfaceIntersection overload and skip the ray cast.
+    SurfaceIntersection light_isect;
+    bool hit = shape_bvh->Intersect(isect.SpawnRay(wi), light_isect);
+    return hit ? PdfLi(isect, light_isect) : 0;
+  }
+  Float PdfLi(const Intersection &isect, const SurfaceIntersection &light_isect) const override {
+    if (shapes.size() == 1) return shapes[0]->Pdf(isect, light_isect);
+    return AreaToSolidAngle(isect.p, light_isect.p, light_isect.geo_frame.n);
   }
   void SampleLe(const Point2f &u1, const Point2f &u2, LightRaySample &sample) const override {
 
@@ -1,94 +1,145 @@
 #include <min/visual/light.h>
-#include <min/visual/image.h>
 #include <min/visual/mipmap.h>
+#include <min/visual/resource_cache.h>
 #include <min/visual/distribution.h>
 #include <min/visual/scene.h>
+#include <min/visual/sampling.h>
+#include <min/math/fastmath.h>
+#include <min/common/parallel.h>
 
 namespace min {
 
 class InfiniteLight : public Light {
-  std::unique_ptr<MIPMap> Lmap;
-  std::unique_ptr<Distribution2D> distribution;
+  std::shared_ptr<const MIPMap> Lmap;
+  // Radiance multiplier, applied at lookup so the map keeps the source texel format
+  Spectrum scale;
+  // Lmap is an equal-area octahedral map instead of lat-long
+  bool octahedral = false;
+  AliasDistribution2D distribution;
   Point3 world_center;
   Float world_radius;
+
+  static Point2f LatLong(const Vector3 &w) {
+    Float phi = MathAtan2(w.y, w.x);
+    if (phi < 0) phi += 2 * kPi;
+    return Point2f(phi * kInv2Pi, MathACos(w.z) * kInvPi);
+  }
+
+  // Resamples a lat-long map to an equal-area octahedral one with about as many texels
+  static std::shared_ptr<const MIPMap> ConvertToOctahedral(const MIPMap &latlong) {
+    int res = RoundUpPow2(std::max(1, int(std::sqrt(Float(latlong.Width()) * latlong.Height()))));
+    MIN_INFO("Converting environment map to {}x{} octahedral", res, res);
+    std::unique_ptr<Vector3[]> texels(new Vector3[res * res]);
+    Float width = 1.f / res;
+    ParallelFor([&](int64_t t) {
+      for (int s = 0; s < res; ++s) {
+        // 2x2 stratified supersampling of the texel
+        Vector3 sum(0.f);
+        for (int j = 0; j < 2; ++j)
+          for (int i = 0; i < 2; ++i) {
+            Point2f st((s + (i + 0.5f) * 0.5f) / res, (t + (j + 0.5f) * 0.5f) / res);
+            sum += latlong.Lookup(LatLong(EqualAreaSquareToSphere(st)), width);
+          }
+        texels[t * res + s] = 0.25f * sum;
+      }
+    }, res);
+    return std::make_shared<MIPMap>(Point2i(res, res), texels.get(), ImageWrapMode::kOctahedral, TexelFormat::kHalf);
+  }
  public:
   void initialize(const Json &json) override {
     flags = LightFlags::kInfinite;
     auto filename = Value<std::string>(json, "filename", "");
     auto L = Value(json, "radiance", Vector3(1));
     auto transform = Value(json, "transform", Transform());
+    // Parameterization of the file, lat-long maps can be converted on load
+    auto mapping = Value<std::string>(json, "mapping", "latlong");
+    auto convert = Value(json, "convert_octahedral", false);
     light2world = transform;
     world2light = Inverse(transform);
-    Point2i resolution;
-    std::unique_ptr<Spectrum[]> texels(nullptr);
-    if (filename != "") {
-      auto texmap = GetFileResolver()->Resolve(filename);
-      texels = ReadImage(texmap.string(), resolution.x, resolution.y);
-      if (texels) {
-        for (int i = 0; i < resolution.x * resolution.y; i++) {
-          texels[i] *= L;
-        }
+    fs::path texmap;
+    if (filename != "") texmap = GetFileResolver()->Resolve(filename);
+    if (!texmap.empty() && fs::exists(texmap)) {
+      octahedral = mapping == "octahedral";
+      TextureCache::ImageOptions options;
+      if (octahedral) options.wrap_mode = ImageWrapMode::kOctahedral;
+      // Same constant as a missing map when the file does not decode
+      options.fallback = 1;
+      Lmap = ResourceCache<MIPMap>::Get().GetOrCreate(
+          ResourceKey(texmap, int(options.wrap_mode), options.gamma, options.flip_y, options.fallback),
+          [&] { return std::make_shared<MIPMap>(TextureCache::Get().AddTexture(texmap.string(), options)); });
+      if (!octahedral && convert) {
+        Lmap = ResourceCache<MIPMap>::Get().GetOrCreate(ResourceKey(texmap, "octahedral"),
+                                                        [&] { return ConvertToOctahedral(*Lmap); });
+        octahedral = true;
       }
+      MIN_WARN_UNLESS(!octahedral || Lmap->Width() == Lmap->Height(),
+                      "Octahedral environment map {} is not square", texmap.string());
+    } else {
+      Vector3 val(1);
+      Lmap = std::make_shared<MIPMap>(Point2i(1), &val);
     }
-    if (!texels) {
-      resolution = Point2i(1);
-      texels.reset(new Vector3[1]);
-      texels[0] = L;
-    }
-    Lmap.reset(new MIPMap(resolution, texels.get()));
+    scale = L;
     int width = 2 * Lmap->Width(), height = 2 * Lmap->Height();
     std::unique_ptr<Float[]> img(new Float[width * height]);
     float fwidth = 0.5f / std::min(width, height);
     for (int64_t v = 0; v < height; v++) {
       Float vp = (v + 0.5f) / Float(height);
-      Float sintheta = std::sin(kPi * (v + 0.5f) / height);
+      // Octahedral texels cover equal solid angles, lat-long rows shrink towards the poles
+      Float sintheta = octahedral ? 1 : std::sin(kPi * (v + 0.5f) / height);
       for (int u = 0; u < width; u++) {
         Float up = (u + 0.5f) / Float(width);
-        img[u + v * width] = Lmap->Lookup(Point2f(up, vp), fwidth).y;
+        img[u + v * width] = (Lmap->Lookup(Point2f(up, vp), fwidth) * scale).y;
         img[u + v * width] *= sintheta;
       }
     }
-    distribution.reset(new Distribution2D(img.get(), width, height));
+    distribution = AliasDistribution2D(img.get(), width, height);
   }
   void Preprocess(const Scene &scene) override {
     scene.PreprocessWorldSphere(world_center, world_radius);
   }
 
+  Spectrum Power() const override {
+    return kPi * world_radius * world_radius * Lmap->Lookup(Point2f(0.5f, 0.5f), 1) * scale;
+  }
+
   Spectrum Le(const Ray &ray) const override {
     Vector3 w = Normalize(world2light.ToVector(ray.d));
-    Float phi = std::atan2(w.y, w.x) < 0 ? std::atan2(w.y, w.x) + 2 * kPi : std::atan2(w.y, w.x);
-    Float theta = std::acos(Clamp(w.z, -1.f, 1.f));
-    Point2f st(phi * kInv2Pi, theta * kInvPi);
-    return Lmap->Lookup(st);
+    Point2f st = octahedral ? EqualAreaSphereToSquare(w) : LatLong(w);
+    return Lmap->Lookup(st) * scale;
   }
   void SampleLi(const Point2f &u,
                 const Intersection &isect,
                 LightSample &sample,
                 VisibilityTester &tester) const override {
     Float map_pdf;
-    Point2f uv = distribution->SampleContinuous(u, &map_pdf);
+    Point2f uv = distribution.SampleContinuous(u, &map_pdf);
     if (map_pdf == 0.f) {
       sample.li = Vector3(0);
       return;
     }
-    Float theta = uv[1] * kPi, phi = uv[0] * 2 * kPi;
-    Float costheta = std::cos(theta), sintheta = std::sin(theta);
-    Float sinphi = std::sin(phi), cosphi = std::cos(phi);
-    sample.wi = light2world.ToVector(Vector3(sintheta * cosphi, sintheta * sinphi, costheta));
-    if (sintheta == 0.f) sample.pdf = 0;
-    else sample.pdf = map_pdf / (2 * kPi * kPi * sintheta);
+    if (octahedral) {
+      sample.wi = light2world.ToVector(EqualAreaSquareToSphere(uv));
+      sample.pdf = map_pdf / (4 * kPi);
+    } else {
+      Float theta = uv[1] * kPi, phi = uv[0] * 2 * kPi;
+      Float costheta, sintheta, sinphi, cosphi;
+      MathSinCos(theta, &sintheta, &costheta);
+      MathSinCos(phi, &sinphi, &cosphi);
+      sample.wi = light2world.ToVector(Vector3(sintheta * cosphi, sintheta * sinphi, costheta));
+      if (sintheta == 0.f) sample.pdf = 0;
+      else sample.pdf = map_pdf / (2 * kPi * kPi * sintheta);
+    }
 
     tester = VisibilityTester(isect, isect.p + sample.wi * (2 * world_radius));
-    sample.li = Lmap->Lookup(uv);
+    sample.li = Lmap->Lookup(uv) * scale;
 
   }
   Float PdfLi(const Intersection &isect, const Vector3 &wiw) const override {
-    Vector3 wi = world2light.ToVector(wiw);
-    Float theta = std::acos(Clamp(wi.z, -1.f, 1.f));
-    Float phi = std::atan2(wi.y, wi.x) < 0 ? std::atan2(wi.y, wi.x) + 2 * kPi : std::atan2(wi.y, wi.x);
-    Float sintheta = std::sin(theta);
+    Vector3 wi = Normalize(world2light.ToVector(wiw));
+    if (octahedral) return distribution.Pdf(EqualAreaSphereToSquare(wi)) / (4 * kPi);
+    Float sintheta = SafeSqrt(1 - wi.z * wi.z);
     if (sintheta == 0.f) return 0;
-    return distribution->Pdf(Point2f(phi * kInv2Pi, theta * kInvPi) / (2 * kPi * kPi * sintheta));
+    return distribution.Pdf(LatLong(wi)) / (2 * kPi * kPi * sintheta);
   }
   void SampleLe(const Point2f &u1, const Point2f &u2, LightRaySample &sample) const override {
 
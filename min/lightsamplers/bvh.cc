@@ -0,0 +1,158 @@
+#include <min/visual/light_sampler.h>
+#include <unordered_map>
+
+namespace min {
+
+// Light BVH that descends towards the child with the larger estimated contribution at the
+// shading point, lights without bounds (environment maps) are sampled uniformly beside it
+class BVHLightSampler : public LightSampler {
+  struct LightBVHNode {
+    LightBounds bounds;
+    // Second child for interior nodes, index into bounded_lights for leaves
+    int child_or_light;
+    bool is_leaf;
+  };
+  static constexpr int kMaxDepth = 64;
+
+  std::vector<const Light *> bounded_lights;
+  std::vector<const Light *> infinite_lights;
+  std::vector<LightBVHNode> nodes;
+  // Path from the root to each light's leaf, bit i set means the second child at depth i
+  std::unordered_map<const Light *, uint64_t> light_to_bit_trail;
+
+  LightBounds BuildBVH(std::vector<std::pair<int, LightBounds>> &lights, int start, int end,
+                       uint64_t bit_trail, int depth) {
+    MIN_ASSERT(start < end && depth < kMaxDepth);
+    if (end - start == 1) {
+      int light = lights[start].first;
+      nodes.push_back({lights[start].second, light, true});
+      light_to_bit_trail[bounded_lights[light]] = bit_trail;
+      return lights[start].second;
+    }
+
+    Bounds3f centroid_bounds;
+    for (int i = start; i < end; ++i)
+      centroid_bounds = Union(centroid_bounds, lights[i].second.Centroid());
+    int dim = centroid_bounds.MaximumExtent();
+    Float pmid = (centroid_bounds.pmin[dim] + centroid_bounds.pmax[dim]) / 2;
+    auto mid_iter = std::partition(lights.begin() + start, lights.begin() + end,
+        [dim, pmid](const std::pair<int, LightBounds> &l) { return l.second.Centroid()[dim] < pmid; });
+    int mid = int(mid_iter - lights.begin());
+    // Coincident centroids, or deep enough that only a balanced split keeps the trail bounded
+    if (mid == start || mid == end || depth > kMaxDepth / 2) {
+      mid = (start + end) / 2;
+      std::nth_element(lights.begin() + start, lights.begin() + mid, lights.begin() + end,
+          [dim](const std::pair<int, LightBounds> &a, const std::pair<int, LightBounds> &b) {
+            return a.second.Centroid()[dim] < b.second.Centroid()[dim];
+          });
+    }
+
+    int node_index = (int)nodes.size();
+    nodes.push_back(LightBVHNode());
+    LightBounds b0 = BuildBVH(lights, start, mid, bit_trail, depth + 1);
+    int second_child = (int)nodes.size();
+    LightBounds b1 = BuildBVH(lights, mid, end, bit_trail | (1ull << depth), depth + 1);
+    LightBounds bounds = Union(b0, b1);
+    nodes[node_index] = {bounds, second_child, false};
+    return bounds;
+  }
+
+  Float InfiniteProbability() const {
+    if (infinite_lights.empty()) return 0;
+    return Float(infinite_lights.size()) / Float(infinite_lights.size() + (nodes.empty() ? 0 : 1));
+  }
+ public:
+  void Build(const std::vector<std::shared_ptr<Light>> &lights) override {
+    bounded_lights.clear();
+    infinite_lights.clear();
+    nodes.clear();
+    light_to_bit_trail.clear();
+    std::vector<std::pair<int, LightBounds>> bvh_lights;
+    for (const auto &light : lights) {
+      LightBounds bounds;
+      if (!light->Bounds(bounds)) {
+        infinite_lights.push_back(light.get());
+      } else if (bounds.phi > 0) {
+        bvh_lights.emplace_back((int)bounded_lights.size(), bounds);
+        bounded_lights.push_back(light.get());
+      }
+    }
+    if (!bvh_lights.empty())
+      BuildBVH(bvh_lights, 0, (int)bvh_lights.size(), 0, 0);
+    MIN_INFO("Built light BVH with {} nodes over {} lights, {} unbounded lights",
+             nodes.size(), bounded_lights.size(), infinite_lights.size());
+  }
+
+  const Light *Sample(const Intersection &ref, Float u, Float *pmf) const override {
+    Float p_infinite = InfiniteProbability();
+    if (u < p_infinite) {
+      u /= p_infinite;
+      int index = std::min((int)(u * infinite_lights.size()), (int)infinite_lights.size() - 1);
+      *pmf = p_infinite / infinite_lights.size();
+      return infinite_lights[index];
+    }
+    if (nodes.empty()) return nullptr;
+
+    const Point3 &p = ref.p;
+    const Normal3 &n = ref.geo_frame.n;
+    u = std::min((u - p_infinite) / (1 - p_infinite), kOneMinusEpsilon);
+    int node_index = 0;
+    Float node_pmf = 1 - p_infinite;
+    while (true) {
+      const LightBVHNode &node = nodes[node_index];
+      if (node.is_leaf) {
+        if (node_index > 0 || node.bounds.Importance(p, n) > 0) {
+          *pmf = node_pmf;
+          return bounded_lights[node.child_or_light];
+        }
+        return nullptr;
+      }
+      // Pick a child proportionally to its importance and rescale u for the next level
+      const int children[2] = {node_index + 1, node.child_or_light};
+      Float ci[2] = {nodes[children[0]].bounds.Importance(p, n),
+                     nodes[children[1]].bounds.Importance(p, n)};
+      if (ci[0] == 0 && ci[1] == 0) return nullptr;
+      Float p0 = ci[0] / (ci[0] + ci[1]);
+      if (u < p0) {
+        u = std::min(u / p0, kOneMinusEpsilon);
+        node_pmf *= p0;
+        node_index = children[0];
+      } else {
+        u = std::min((u - p0) / (1 - p0), kOneMinusEpsilon);
+        node_pmf *= 1 - p0;
+        node_index = children[1];
+      }
+    }
+  }
+
+  Float Pmf(const Intersection &ref, const Light *light) const override {
+    auto it = light_to_bit_trail.find(light);
+    if (it == light_to_bit_trail.end()) {
+      bool infinite = std::find(infinite_lights.begin(), infinite_lights.end(), light) != infinite_lights.end();
+      return infinite ? InfiniteProbability() / infinite_lights.size() : 0;
+    }
+
+    // Replay the traversal decisions recorded in the bit trail
+    const Point3 &p = ref.p;
+    const Normal3 &n = ref.geo_frame.n;
+    uint64_t bit_trail = it->second;
+    Float pmf = 1 - InfiniteProbability();
+    int node_index = 0;
+    while (!nodes[node_index].is_leaf) {
+      const LightBVHNode &node = nodes[node_index];
+      const int children[2] = {node_index + 1, node.child_or_light};
+      Float ci[2] = {nodes[children[0]].bounds.Importance(p, n),
+                     nodes[children[1]].bounds.Importance(p, n)};
+      if (ci[0] == 0 && ci[1] == 0) return 0;
+      int child = bit_trail & 1;
+      pmf *= ci[child] / (ci[0] + ci[1]);
+      node_index = children[child];
+      bit_trail >>= 1;
+    }
+    return pmf;
+  }
+};
+MIN_IMPLEMENTATION(LightSampler, BVHLightSampler, "bvh")
+
+}
+
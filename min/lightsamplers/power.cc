@@ -0,0 +1,43 @@
+#include <min/visual/light_sampler.h>
+#include <min/visual/distribution.h>
+#include <unordered_map>
+#include <numeric>
+
+namespace min {
+
+// Picks lights proportionally to their emitted power regardless of the shading point
+class PowerLightSampler : public LightSampler {
+  std::vector<const Light *> lights;
+  std::unordered_map<const Light *, int> light_to_index;
+  AliasTable distrib;
+ public:
+  void Build(const std::vector<std::shared_ptr<Light>> &lights_) override {
+    lights.clear();
+    light_to_index.clear();
+    distrib = AliasTable();
+    if (lights_.empty()) return;
+    std::vector<Float> power;
+    for (const auto &light : lights_) {
+      light_to_index[light.get()] = (int)lights.size();
+      lights.push_back(light.get());
+      power.push_back(Luminance(light->Power()));
+    }
+    // Fall back to uniform selection if no light reports its power
+    if (std::accumulate(power.begin(), power.end(), Float(0)) == 0)
+      std::fill(power.begin(), power.end(), Float(1));
+    distrib = AliasTable(power.data(), (int)power.size());
+  }
+  const Light *Sample(const Intersection &ref, Float u, Float *pmf) const override {
+    if (!distrib.Count()) return nullptr;
+    return lights[distrib.Sample(u, pmf)];
+  }
+  Float Pmf(const Intersection &ref, const Light *light) const override {
+    auto it = light_to_index.find(light);
+    if (it == light_to_index.end()) return 0;
+    return distrib.Pmf(it->second);
+  }
+};
+MIN_IMPLEMENTATION(LightSampler, PowerLightSampler, "power")
+
+}
+
@@ -0,0 +1,25 @@
+#include <min/visual/light_sampler.h>
+
+namespace min {
+
+class UniformLightSampler : public LightSampler {
+  std::vector<const Light *> lights;
+ public:
+  void Build(const std::vector<std::shared_ptr<Light>> &lights_) override {
+    lights.clear();
+    for (const auto &light : lights_) lights.push_back(light.get());
+  }
+  const Light *Sample(const Intersection &ref, Float u, Float *pmf) const override {
+    if (lights.empty()) return nullptr;
+    int light_num = std::min((int)(u * lights.size()), (int)lights.size() - 1);
+    *pmf = 1.f / lights.size();
+    return lights[light_num];
+  }
+  Float Pmf(const Intersection &ref, const Light *light) const override {
+    return lights.empty() ? 0 : 1.f / lights.size();
+  }
+};
+MIN_IMPLEMENTATION(LightSampler, UniformLightSampler, "uniform")
+
+}
+
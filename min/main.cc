@@ -4,6 +4,8 @@
 #include <min/visual/renderer.h>
 #include <min/visual/scene.h>
 #include <min/visual/aggregate.h>
+#include <min/visual/texture_cache.h>
+#include <min/common/cpu.h>
 #include <fstream>
 
 using namespace min;
@@ -16,6 +18,10 @@ int main() {
     std::ifstream is(tmp);
     Json j;
     is >> j;
+    if (j.contains("texture_cache"))
+      TextureCache::Get().SetBudget(size_t(Value(j["texture_cache"], "budget_mb", 1024)) << 20U);
+    // Kernel variants for this host, "auto" unless overridden here or by MIN_CPU_TARGET
+    SelectCpuTarget(Value<std::string>(j, "cpu_target", "auto"));
     auto camera = CreateInstance<Camera>(j["camera"]["type"], GetProps(j.at("camera")));
     auto scene = CreateInstance<Scene>("scene", "");
     auto accel = CreateInstance<Accelerator>(j["accelerator"]["type"], GetProps(j["accelerator"]));
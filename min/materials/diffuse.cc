@@ -4,14 +4,6 @@
 
 namespace min {
 
-class DiffuseBRDF : public BxDF {
- public:
-  const Spectrum R;
-  DiffuseBRDF(const Spectrum &R) : BxDF(Type(kReflection | kDiffuse)), R(R) {}
-  Spectrum Evaluate(const Vector3f &wo, const Vector3f &wi) const override {
-    return R * kInvPi;
-  }
-};
 class DiffuseMaterial : public Material {
   std::shared_ptr<Texture> kd;
  public:
@@ -22,10 +14,10 @@ class DiffuseMaterial : public Material {
       kd = CreateInstance<Texture>("constant", {});
     }
   }
-  void ComputeScatteringEvents(SurfaceIntersection &si) const override {
-    si.bsdf = std::make_unique<BSDF>(si.geo_frame, si.shading_frame);
+  void ComputeScatteringEvents(SurfaceIntersection &si, MemoryArena &arena) const override {
+    si.bsdf = MIN_ARENA_ALLOC(arena, BSDF)(si.geo_frame, si.shading_frame);
     Spectrum albedo = kd->Evaluate(si.sp);
-    si.bsdf->Add(std::make_shared<DiffuseBRDF>(albedo));
+    si.bsdf->Add(DiffuseBRDF(albedo));
   }
 };
 MIN_IMPLEMENTATION(Material, DiffuseMaterial, "diffuse")
@@ -0,0 +1,272 @@
+#pragma once
+
+#include "linalg.h"
+#include <cstring>
+
+namespace min {
+
+// Polynomial approximations of the transcendental functions in sampling code, after Cephes. Every
+// kernel is written once over scalar and 4 lane (Vector4f) operations, both evaluate the same
+// operations in the same order so lanes match the scalar result bit for bit. Maximum errors over
+// the valid range, checked in tests.cc:
+//   FastSinCos  |x| <= 8192          1e-7 absolute
+//   FastAtan2   finite               3 ulp
+//   FastACos    [-1, 1]              3e-7 absolute
+//   FastExp     [-87.3, 88]          1 ulp, saturates outside
+//   FastLog     normal x > 0         1 ulp, 0 gives -inf and negative numbers NaN
+// Sampling code goes through the Math* wrappers at the bottom, which use these when MIN_FAST_MATH
+// is defined and libm otherwise
+namespace fastmath {
+
+// Lane helpers, a scalar mask is a bool and a vector mask has all bits of a lane set
+MIN_FORCE_INLINE bool Lt(float32 a, float32 b) { return a < b; }
+MIN_FORCE_INLINE bool Gt(float32 a, float32 b) { return a > b; }
+MIN_FORCE_INLINE bool Eq(float32 a, float32 b) { return a == b; }
+MIN_FORCE_INLINE float32 Min(float32 a, float32 b) { return a < b ? a : b; }
+MIN_FORCE_INLINE float32 Max(float32 a, float32 b) { return a > b ? a : b; }
+MIN_FORCE_INLINE float32 Sqrt(float32 a) { return std::sqrt(a); }
+
+MIN_FORCE_INLINE uint32_t Bits(float32 a) {
+  uint32_t b;
+  std::memcpy(&b, &a, sizeof(b));
+  return b;
+}
+
+MIN_FORCE_INLINE float32 FromBits(uint32_t b) {
+  float32 a;
+  std::memcpy(&a, &b, sizeof(a));
+  return a;
+}
+
+// Bitwise so compilers keep it branch free, quadrants and ranges are unpredictable in sampling code
+MIN_FORCE_INLINE float32 Select(bool m, float32 a, float32 b) {
+  uint32_t mask = 0U - uint32_t(m);
+  return FromBits((Bits(a) & mask) | (Bits(b) & ~mask));
+}
+
+MIN_FORCE_INLINE float32 Abs(float32 a) { return FromBits(Bits(a) & 0x7fffffffU); }
+
+// Magnitude of a, sign of b
+MIN_FORCE_INLINE float32 CopySign(float32 a, float32 b) {
+  return FromBits((Bits(a) & 0x7fffffffU) | (Bits(b) & 0x80000000U));
+}
+
+// 2^n for integral n in [-126, 127]
+MIN_FORCE_INLINE float32 Pow2(float32 n) { return FromBits(uint32_t(int32_t(n) + 127) << 23U); }
+
+// a = m * 2^e with m in [0.5, 1), for normal a
+MIN_FORCE_INLINE float32 Frexp(float32 a, float32 *m) {
+  uint32_t b = Bits(a);
+  *m = FromBits((b & 0x007fffffU) | 0x3f000000U);
+  return float32(int32_t(b >> 23U) - 126);
+}
+
+// Quadrant masks of the sine and cosine reduction for integral q
+MIN_FORCE_INLINE void Quadrant(float32 q, bool *swap, bool *negate_sin, bool *negate_cos) {
+  uint32_t n = uint32_t(int32_t(q));
+  *swap = n & 1U;
+  *negate_sin = n & 2U;
+  *negate_cos = (n + 1U) & 2U;
+}
+
+MIN_FORCE_INLINE float32 Negate(float32 a, bool m) { return FromBits(Bits(a) ^ (uint32_t(m) << 31U)); }
+
+#if defined(MIN_SIMD_SSE)
+using Lanes = Vector4f;
+
+MIN_FORCE_INLINE Lanes Lt(const Lanes &a, const Lanes &b) { return Lanes(_mm_cmplt_ps(a.v, b.v)); }
+MIN_FORCE_INLINE Lanes Gt(const Lanes &a, const Lanes &b) { return Lanes(_mm_cmpgt_ps(a.v, b.v)); }
+MIN_FORCE_INLINE Lanes Eq(const Lanes &a, const Lanes &b) { return Lanes(_mm_cmpeq_ps(a.v, b.v)); }
+MIN_FORCE_INLINE Lanes Select(const Lanes &m, const Lanes &a, const Lanes &b) {
+  return Lanes(_mm_or_ps(_mm_and_ps(m.v, a.v), _mm_andnot_ps(m.v, b.v)));
+}
+MIN_FORCE_INLINE Lanes Min(const Lanes &a, const Lanes &b) { return Lanes(_mm_min_ps(a.v, b.v)); }
+MIN_FORCE_INLINE Lanes Max(const Lanes &a, const Lanes &b) { return Lanes(_mm_max_ps(a.v, b.v)); }
+MIN_FORCE_INLINE Lanes Sqrt(const Lanes &a) { return Lanes(_mm_sqrt_ps(a.v)); }
+
+MIN_FORCE_INLINE __m128 SignMask() { return _mm_castsi128_ps(_mm_set1_epi32(int32_t(0x80000000U))); }
+
+MIN_FORCE_INLINE Lanes Abs(const Lanes &a) { return Lanes(_mm_andnot_ps(SignMask(), a.v)); }
+
+MIN_FORCE_INLINE Lanes CopySign(const Lanes &a, const Lanes &b) {
+  return Lanes(_mm_or_ps(_mm_andnot_ps(SignMask(), a.v), _mm_and_ps(SignMask(), b.v)));
+}
+
+MIN_FORCE_INLINE Lanes Pow2(const Lanes &n) {
+  __m128i e = _mm_add_epi32(_mm_cvttps_epi32(n.v), _mm_set1_epi32(127));
+  return Lanes(_mm_castsi128_ps(_mm_slli_epi32(e, 23)));
+}
+
+MIN_FORCE_INLINE Lanes Frexp(const Lanes &a, Lanes *m) {
+  __m128i b = _mm_castps_si128(a.v);
+  *m = Lanes(_mm_castsi128_ps(_mm_or_si128(_mm_and_si128(b, _mm_set1_epi32(0x007fffff)),
+                                           _mm_set1_epi32(0x3f000000))));
+  return Lanes(_mm_cvtepi32_ps(_mm_sub_epi32(_mm_srli_epi32(b, 23), _mm_set1_epi32(126))));
+}
+
+MIN_FORCE_INLINE void Quadrant(const Lanes &q, Lanes *swap, Lanes *negate_sin, Lanes *negate_cos) {
+  __m128i n = _mm_cvttps_epi32(q.v);
+  const __m128i zero = _mm_setzero_si128();
+  *swap = Lanes(_mm_castsi128_ps(
+      _mm_xor_si128(_mm_cmpeq_epi32(_mm_and_si128(n, _mm_set1_epi32(1)), zero), _mm_set1_epi32(-1))));
+  *negate_sin = Lanes(_mm_castsi128_ps(
+      _mm_xor_si128(_mm_cmpeq_epi32(_mm_and_si128(n, _mm_set1_epi32(2)), zero), _mm_set1_epi32(-1))));
+  __m128i n1 = _mm_add_epi32(n, _mm_set1_epi32(1));
+  *negate_cos = Lanes(_mm_castsi128_ps(
+      _mm_xor_si128(_mm_cmpeq_epi32(_mm_and_si128(n1, _mm_set1_epi32(2)), zero), _mm_set1_epi32(-1))));
+}
+
+MIN_FORCE_INLINE Lanes Negate(const Lanes &a, const Lanes &m) {
+  return Lanes(_mm_xor_ps(a.v, _mm_and_ps(m.v, SignMask())));
+}
+#endif
+
+// Round to nearest even, exact for |x| < 2^22
+template <typename V>
+MIN_FORCE_INLINE V Round(const V &x) {
+  const V magic(12582912.f);
+  return (x + magic) - magic;
+}
+
+template <typename V>
+MIN_FORCE_INLINE void SinCos(const V &x, V *s, V *c) {
+  // Cody-Waite reduction to [-pi / 4, pi / 4] with pi / 2 split in three, the first parts have
+  // few enough bits that their products with q are exact
+  V q = Round(x * V(0.636619772367581343f));
+  V r = ((x - q * V(1.5703125f)) - q * V(4.837512969970703125e-4f)) - q * V(7.54978995489188216e-8f);
+  V r2 = r * r;
+  V sin_r = r + r * r2 * (V(-1.6666654611e-1f) + r2 * (V(8.3321608736e-3f) + r2 * V(-1.9515295891e-4f)));
+  V cos_r = (V(1.f) - V(0.5f) * r2) +
+      r2 * r2 * (V(4.166664568298827e-2f) + r2 * (V(-1.388731625493765e-3f) + r2 * V(2.443315711809948e-5f)));
+  decltype(Lt(x, x)) swap, negate_sin, negate_cos;
+  Quadrant(q, &swap, &negate_sin, &negate_cos);
+  *s = Negate(Select(swap, cos_r, sin_r), negate_sin);
+  *c = Negate(Select(swap, sin_r, cos_r), negate_cos);
+}
+
+// atan(t) for t in [0, 1]
+template <typename V>
+MIN_FORCE_INLINE V AtanUnit(const V &t) {
+  auto above = Gt(t, V(0.414213562373095049f));
+  V u = Select(above, (t - V(1.f)) / (t + V(1.f)), t);
+  V z = u * u;
+  V p = (((V(8.05374449538e-2f) * z - V(1.38776856032e-1f)) * z + V(1.99777106478e-1f)) * z -
+      V(3.33329491539e-1f)) * z * u + u;
+  return Select(above, V(0.785398163397448309f) + p, p);
+}
+
+template <typename V>
+MIN_FORCE_INLINE V Atan2(const V &y, const V &x) {
+  V ax = Abs(x), ay = Abs(y);
+  V hi = Max(ax, ay), lo = Min(ax, ay);
+  // Both zero gives 0 like libm
+  V t = Select(Eq(hi, V(0.f)), V(0.f), lo / hi);
+  V a = AtanUnit(t);
+  a = Select(Gt(ay, ax), V(1.57079632679489661923f) - a, a);
+  a = Select(Lt(x, V(0.f)), V(3.14159265358979323846f) - a, a);
+  return CopySign(a, y);
+}
+
+template <typename V>
+MIN_FORCE_INLINE V ACos(const V &x) {
+  V ax = Min(Abs(x), V(1.f));
+  // Near +-1 acos goes through 2 asin(sqrt((1 - |x|) / 2)), which keeps its accuracy
+  auto large = Gt(ax, V(0.5f));
+  V z = Select(large, V(0.5f) * (V(1.f) - ax), ax * ax);
+  V s = Select(large, Sqrt(z), ax);
+  V asin_s = ((((V(4.2163199048e-2f) * z + V(2.4181311049e-2f)) * z + V(4.5470025998e-2f)) * z +
+      V(7.4953002686e-2f)) * z + V(1.6666752422e-1f)) * z * s + s;
+  V a = Select(large, V(2.f) * asin_s, V(1.57079632679489661923f) - asin_s);
+  return Select(Lt(x, V(0.f)), V(3.14159265358979323846f) - a, a);
+}
+
+template <typename V>
+MIN_FORCE_INLINE V Exp(const V &x) {
+  V xc = Min(Max(x, V(-87.3365447f)), V(88.f));
+  V n = Round(xc * V(1.44269504088896341f));
+  // ln 2 split in two, the first part is exact in its product with n
+  V r = (xc - n * V(0.693359375f)) - n * V(-2.12194440e-4f);
+  V p = (((((V(1.9875691500e-4f) * r + V(1.3981999507e-3f)) * r + V(8.3334519073e-3f)) * r +
+      V(4.1665795894e-2f)) * r + V(1.6666665459e-1f)) * r + V(5.0000001201e-1f)) * (r * r) + r + V(1.f);
+  return p * Pow2(n);
+}
+
+template <typename V>
+MIN_FORCE_INLINE V Log(const V &x) {
+  V m;
+  V e = Frexp(x, &m);
+  // m in [sqrt(1 / 2), sqrt(2)) centers the polynomial on 1
+  auto low = Lt(m, V(0.707106781186547524f));
+  e = Select(low, e - V(1.f), e);
+  m = Select(low, m + m, m) - V(1.f);
+  V z = m * m;
+  V y = ((((((((V(7.0376836292e-2f) * m - V(1.1514610310e-1f)) * m + V(1.1676998740e-1f)) * m -
+      V(1.2420140846e-1f)) * m + V(1.4249322787e-1f)) * m - V(1.6668057665e-1f)) * m +
+      V(2.0000714765e-1f)) * m - V(2.4999993993e-1f)) * m + V(3.3333331174e-1f)) * m * z;
+  y = (y + e * V(-2.12194440e-4f)) - V(0.5f) * z;
+  V ret = (m + y) + e * V(0.693359375f);
+  ret = Select(Eq(x, V(0.f)), V(-std::numeric_limits<float32>::infinity()), ret);
+  return Select(Lt(x, V(0.f)), V(std::numeric_limits<float32>::quiet_NaN()), ret);
+}
+
+}
+
+MIN_FORCE_INLINE void FastSinCos(float32 x, float32 *s, float32 *c) { fastmath::SinCos(x, s, c); }
+MIN_FORCE_INLINE float32 FastSin(float32 x) {
+  float32 s, c;
+  fastmath::SinCos(x, &s, &c);
+  return s;
+}
+MIN_FORCE_INLINE float32 FastCos(float32 x) {
+  float32 s, c;
+  fastmath::SinCos(x, &s, &c);
+  return c;
+}
+MIN_FORCE_INLINE float32 FastAtan2(float32 y, float32 x) { return fastmath::Atan2(y, x); }
+MIN_FORCE_INLINE float32 FastACos(float32 x) { return fastmath::ACos(x); }
+MIN_FORCE_INLINE float32 FastExp(float32 x) { return fastmath::Exp(x); }
+MIN_FORCE_INLINE float32 FastLog(float32 x) { return fastmath::Log(x); }
+
+// Four lanes at once, lane by lane without SSE
+#if defined(MIN_SIMD_SSE)
+MIN_FORCE_INLINE void FastSinCos(const Vector4f &x, Vector4f *s, Vector4f *c) { fastmath::SinCos(x, s, c); }
+MIN_FORCE_INLINE Vector4f FastAtan2(const Vector4f &y, const Vector4f &x) { return fastmath::Atan2(y, x); }
+MIN_FORCE_INLINE Vector4f FastACos(const Vector4f &x) { return fastmath::ACos(x); }
+MIN_FORCE_INLINE Vector4f FastExp(const Vector4f &x) { return fastmath::Exp(x); }
+MIN_FORCE_INLINE Vector4f FastLog(const Vector4f &x) { return fastmath::Log(x); }
+#else
+MIN_FORCE_INLINE void FastSinCos(const Vector4f &x, Vector4f *s, Vector4f *c) {
+  for (int i = 0; i < 4; ++i) fastmath::SinCos(x[i], &(*s)[i], &(*c)[i]);
+}
+MIN_FORCE_INLINE Vector4f FastAtan2(const Vector4f &y, const Vector4f &x) {
+  return Vector4f([&](int i) { return fastmath::Atan2(y[i], x[i]); });
+}
+MIN_FORCE_INLINE Vector4f FastACos(const Vector4f &x) {
+  return Vector4f([&](int i) { return fastmath::ACos(x[i]); });
+}
+MIN_FORCE_INLINE Vector4f FastExp(const Vector4f &x) {
+  return Vector4f([&](int i) { return fastmath::Exp(x[i]); });
+}
+MIN_FORCE_INLINE Vector4f FastLog(const Vector4f &x) {
+  return Vector4f([&](int i) { return fastmath::Log(x[i]); });
+}
+#endif
+
+#if defined(MIN_FAST_MATH) && !defined(MIN_USE_DOUBLE)
+MIN_FORCE_INLINE void MathSinCos(Float x, Float *s, Float *c) { FastSinCos(x, s, c); }
+MIN_FORCE_INLINE Float MathAtan2(Float y, Float x) { return FastAtan2(y, x); }
+MIN_FORCE_INLINE Float MathACos(Float x) { return FastACos(x); }
+MIN_FORCE_INLINE Float MathExp(Float x) { return FastExp(x); }
+MIN_FORCE_INLINE Float MathLog(Float x) { return FastLog(x); }
+#else
+MIN_FORCE_INLINE void MathSinCos(Float x, Float *s, Float *c) {
+  *s = std::sin(x);
+  *c = std::cos(x);
+}
+MIN_FORCE_INLINE Float MathAtan2(Float y, Float x) { return std::atan2(y, x); }
+MIN_FORCE_INLINE Float MathACos(Float x) { return std::acos(Clamp(x, (Float)-1, (Float)1)); }
+MIN_FORCE_INLINE Float MathExp(Float x) { return std::exp(x); }
+MIN_FORCE_INLINE Float MathLog(Float x) { return std::log(x); }
+#endif
+
+}
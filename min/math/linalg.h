@@ -4,13 +4,25 @@
 #include <min/common/util.h>
 #include <functional>
 
+#if !defined(MIN_NO_SIMD) && (defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2))
+#define MIN_SIMD_SSE
+#include <immintrin.h>
+#endif
+
 namespace min {
 
 // Reference for https://github.com/taichi-dev/taichi/blob/master/taichi/math/linalg.h
 
-enum InstSetExt { kNone };
+// Ordered, an extension implies the ones before it
+enum InstSetExt { kNone, kSSE, kAVX };
 
+#if defined(MIN_SIMD_SSE) && defined(__AVX__)
+constexpr InstSetExt kDefaultInstructionSet = InstSetExt::kAVX;
+#elif defined(MIN_SIMD_SSE)
+constexpr InstSetExt kDefaultInstructionSet = InstSetExt::kSSE;
+#else
 constexpr InstSetExt kDefaultInstructionSet = InstSetExt::kNone;
+#endif
 
 //******************************************************************************
 //                           N dimensional vector
@@ -71,6 +83,42 @@ struct VectorNDBase<4, T, ISE> {
   };
 };
 
+#if defined(MIN_SIMD_SSE)
+// Float vectors of 3 and 4 elements live in one SSE register, a 3 vector pads the w lane which no
+// operation reads back
+template<>
+struct VectorNDBase<3, float32, kSSE> {
+  static constexpr bool kSimd = true;
+  static constexpr int kStorageElements = 4;
+  union {
+    __m128 v = _mm_setzero_ps();
+    float32 d[4];
+    struct {
+      float32 x, y, z, _w;
+    };
+  };
+};
+
+template<>
+struct VectorNDBase<4, float32, kSSE> {
+  static constexpr bool kSimd = true;
+  static constexpr int kStorageElements = 4;
+  union {
+    __m128 v = _mm_setzero_ps();
+    float32 d[4];
+    struct {
+      float32 x, y, z, w;
+    };
+  };
+};
+
+template<>
+struct VectorNDBase<3, float32, kAVX> : VectorNDBase<3, float32, kSSE> {};
+
+template<>
+struct VectorNDBase<4, float32, kAVX> : VectorNDBase<4, float32, kSSE> {};
+#endif
+
 template<int dim__, typename T, InstSetExt ISE = kDefaultInstructionSet>
 struct VectorND : public VectorNDBase<dim__, T, ISE> {
   static constexpr int kDim = dim__;
@@ -110,10 +158,23 @@ struct VectorND : public VectorNDBase<dim__, T, ISE> {
   // Scalar initialization
   template<typename F, std::enable_if_t<std::is_same<F, T>::value, int> = 0>
   explicit MIN_FORCE_INLINE VectorND(const F &f) {
+#if defined(MIN_SIMD_SSE)
+    if constexpr (VectorBase::kSimd) {
+      this->v = _mm_set1_ps(f);
+      return;
+    }
+#endif
     for (int i = 0; i < kDim; i++)
       this->d[i] = f;
   }
 
+#if defined(MIN_SIMD_SSE)
+  explicit MIN_FORCE_INLINE VectorND(__m128 v) {
+    static_assert(VectorBase::kSimd, "Vector is not stored in a SSE register");
+    this->v = v;
+  }
+#endif
+
   // Function intialization
   template<
       typename F,
@@ -141,6 +202,12 @@ struct VectorND : public VectorNDBase<dim__, T, ISE> {
   template<int dim_ = kDim, typename T_ = T, InstSetExt ISE_ = ISE>
   explicit MIN_FORCE_INLINE VectorND(T v0, T v1, T v2) {
     static_assert(kDim == 3, "Vector dim must be 3");
+#if defined(MIN_SIMD_SSE)
+    if constexpr (VectorBase::kSimd) {
+      this->v = _mm_setr_ps(v0, v1, v2, 0);
+      return;
+    }
+#endif
     this->d[0] = v0;
     this->d[1] = v1;
     this->d[2] = v2;
@@ -150,6 +217,12 @@ struct VectorND : public VectorNDBase<dim__, T, ISE> {
   template<int dim_ = kDim, typename T_ = T, InstSetExt ISE_ = ISE>
   explicit MIN_FORCE_INLINE VectorND(T v0, T v1, T v2, T v3) {
     static_assert(kDim == 4, "Vector dim must be 4");
+#if defined(MIN_SIMD_SSE)
+    if constexpr (VectorBase::kSimd) {
+      this->v = _mm_setr_ps(v0, v1, v2, v3);
+      return;
+    }
+#endif
     this->d[0] = v0;
     this->d[1] = v1;
     this->d[2] = v2;
@@ -194,6 +267,16 @@ struct VectorND : public VectorNDBase<dim__, T, ISE> {
   }
 
   MIN_FORCE_INLINE T Dot(VectorND<kDim, T, ISE> o) const {
+#if defined(MIN_SIMD_SSE)
+    if constexpr (VectorBase::kSimd) {
+      // Summed in the same order as the scalar loop, equal to it unless the compiler fuses either into FMAs
+      __m128 p = _mm_mul_ps(this->v, o.v);
+      __m128 sum = _mm_add_ss(p, _mm_shuffle_ps(p, p, _MM_SHUFFLE(1, 1, 1, 1)));
+      sum = _mm_add_ss(sum, _mm_shuffle_ps(p, p, _MM_SHUFFLE(2, 2, 2, 2)));
+      if constexpr (kDim == 4) sum = _mm_add_ss(sum, _mm_shuffle_ps(p, p, _MM_SHUFFLE(3, 3, 3, 3)));
+      return _mm_cvtss_f32(sum);
+    }
+#endif
     T ret = T(0);
     for (int i = 0; i < kDim; i++)
       ret += this->d[i] * o[i];
@@ -205,24 +288,35 @@ struct VectorND : public VectorNDBase<dim__, T, ISE> {
     return *this;
   }
 
-  // Non-SIMD cases
   template<int dim_ = kDim, typename T_ = T, InstSetExt ISE_ = ISE>
   MIN_FORCE_INLINE VectorND operator+(const VectorND &o) const {
+#if defined(MIN_SIMD_SSE)
+    if constexpr (VectorBase::kSimd) return VectorND(_mm_add_ps(this->v, o.v));
+#endif
     return VectorND([=](int i) { return this->d[i] + o[i]; });
   }
 
   template<int dim_ = kDim, typename T_ = T, InstSetExt ISE_ = ISE>
   MIN_FORCE_INLINE VectorND operator-(const VectorND &o) const {
+#if defined(MIN_SIMD_SSE)
+    if constexpr (VectorBase::kSimd) return VectorND(_mm_sub_ps(this->v, o.v));
+#endif
     return VectorND([=](int i) { return this->d[i] - o[i]; });
   }
 
   template<int dim_ = kDim, typename T_ = T, InstSetExt ISE_ = ISE>
   MIN_FORCE_INLINE VectorND operator*(const VectorND &o) const {
+#if defined(MIN_SIMD_SSE)
+    if constexpr (VectorBase::kSimd) return VectorND(_mm_mul_ps(this->v, o.v));
+#endif
     return VectorND([=](int i) { return this->d[i] * o[i]; });
   }
 
   template<int dim_ = kDim, typename T_ = T, InstSetExt ISE_ = ISE>
   MIN_FORCE_INLINE VectorND operator/(const VectorND &o) const {
+#if defined(MIN_SIMD_SSE)
+    if constexpr (VectorBase::kSimd) return VectorND(_mm_div_ps(this->v, o.v));
+#endif
     return VectorND([=](int i) { return this->d[i] / o[i]; });
   }
 
@@ -268,6 +362,9 @@ struct VectorND : public VectorNDBase<dim__, T, ISE> {
   }
 
   MIN_FORCE_INLINE VectorND operator-() const {
+#if defined(MIN_SIMD_SSE)
+    if constexpr (VectorBase::kSimd) return VectorND(_mm_xor_ps(this->v, _mm_set1_ps(-0.f)));
+#endif
     return VectorND([=](int i) { return -this->d[i]; });
   }
 
@@ -340,6 +437,9 @@ struct VectorND : public VectorNDBase<dim__, T, ISE> {
 
   template<int dim_ = kDim, typename T_ = T, InstSetExt ISE_ = ISE>
   MIN_FORCE_INLINE T LengthSquared() const {
+#if defined(MIN_SIMD_SSE)
+    if constexpr (VectorBase::kSimd) return Dot(*this);
+#endif
     T ret = 0;
     for (int i = 0; i < kDim; i++) {
       ret += this->d[i] * this->d[i];
@@ -418,6 +518,15 @@ MIN_FORCE_INLINE T Cross(const VectorND<2, T, ISE> &a,
 template <typename T, InstSetExt ISE>
 MIN_FORCE_INLINE VectorND<3, T, ISE> Cross(const VectorND<3, T, ISE> &a,
                                           const VectorND<3, T, ISE> &b) {
+#if defined(MIN_SIMD_SSE)
+  if constexpr (VectorND<3, T, ISE>::kSimd) {
+    __m128 a_yzx = _mm_shuffle_ps(a.v, a.v, _MM_SHUFFLE(3, 0, 2, 1));
+    __m128 b_yzx = _mm_shuffle_ps(b.v, b.v, _MM_SHUFFLE(3, 0, 2, 1));
+    __m128 a_zxy = _mm_shuffle_ps(a.v, a.v, _MM_SHUFFLE(3, 1, 0, 2));
+    __m128 b_zxy = _mm_shuffle_ps(b.v, b.v, _MM_SHUFFLE(3, 1, 0, 2));
+    return VectorND<3, T, ISE>(_mm_sub_ps(_mm_mul_ps(a_yzx, b_zxy), _mm_mul_ps(a_zxy, b_yzx)));
+  }
+#endif
   return VectorND<3, T, ISE>(a.y * b.z - a.z * b.y, a.z * b.x - a.x * b.z,
       a.x * b.y - a.y * b.x);
 }
@@ -443,6 +552,10 @@ MIN_FORCE_INLINE T AbsDot(const VectorND<dim, T, ISE> &a,
 template <int dim, typename T>
 MIN_FORCE_INLINE VectorND<dim, T> Min(const VectorND<dim, T> &a,
                                      const VectorND<dim, T> &b) {
+  // Operands swapped to pick the same one as std::min for NaNs and signed zeros
+#if defined(MIN_SIMD_SSE)
+  if constexpr (VectorND<dim, T>::kSimd) return VectorND<dim, T>(_mm_min_ps(b.v, a.v));
+#endif
   VectorND<dim, T> ret;
   for (int i = 0; i < dim; i++) {
     ret[i] = std::min(a[i], b[i]);
@@ -453,6 +566,9 @@ MIN_FORCE_INLINE VectorND<dim, T> Min(const VectorND<dim, T> &a,
 template <int dim, typename T>
 MIN_FORCE_INLINE VectorND<dim, T> Max(const VectorND<dim, T> &a,
                                      const VectorND<dim, T> &b) {
+#if defined(MIN_SIMD_SSE)
+  if constexpr (VectorND<dim, T>::kSimd) return VectorND<dim, T>(_mm_max_ps(b.v, a.v));
+#endif
   VectorND<dim, T> ret;
   for (int i = 0; i < dim; i++) {
     ret[i] = std::max(a[i], b[i]);
@@ -487,7 +603,7 @@ MIN_FORCE_INLINE VectorND<dim, T, ISE> Normalize(
 template <int dim, typename T, InstSetExt ISE>
 MIN_FORCE_INLINE VectorND<dim, T, ISE> Permute(
     const VectorND<dim, T, ISE> &a, const VectorND<dim, int, ISE> &permute) {
-  VectorND<dim, T> ret;
+  VectorND<dim, T, ISE> ret;
   for (int i = 0; i < dim; i++) {
     ret[i] = a[permute[i]];
   }
@@ -497,7 +613,11 @@ MIN_FORCE_INLINE VectorND<dim, T, ISE> Permute(
 template <int dim, typename T, InstSetExt ISE>
 MIN_FORCE_INLINE VectorND<dim, T, ISE> Abs(
     const VectorND<dim, T, ISE> &a) {
-  VectorND<dim, T> ret;
+#if defined(MIN_SIMD_SSE)
+  if constexpr (VectorND<dim, T, ISE>::kSimd)
+    return VectorND<dim, T, ISE>(_mm_andnot_ps(_mm_set1_ps(-0.f), a.v));
+#endif
+  VectorND<dim, T, ISE> ret;
   for (int i = 0; i < dim; i++) {
     ret[i] = std::abs(a[i]);
   }
@@ -519,6 +639,9 @@ MIN_FORCE_INLINE T MinComp(
 template <int dim, typename T, InstSetExt ISE>
 MIN_FORCE_INLINE VectorND<dim, T, ISE> Sqrt(
     const VectorND<dim, T, ISE> &a) {
+#if defined(MIN_SIMD_SSE)
+  if constexpr (VectorND<dim, T, ISE>::kSimd) return VectorND<dim, T, ISE>(_mm_sqrt_ps(a.v));
+#endif
   VectorND<dim, T, ISE> ret;
   for (int i = 0; i < dim; i++) {
     ret[i] = std::sqrt(a[i]);
@@ -684,6 +807,36 @@ struct MatrixND {
   template <int dim_ = kDim, typename T_ = T, InstSetExt ISE_ = ISE>
   MIN_FORCE_INLINE MatrixND operator*(const MatrixND &o) const {
     MatrixND ret;
+#if defined(MIN_SIMD_SSE)
+    if constexpr (kDim == 4 && Vector::kSimd) {
+      // Row i of the product is sum_k (*this)[i][k] * o[k], accumulated in the scalar order
+#if defined(__AVX__)
+      if constexpr (ISE >= kAVX) {
+        __m256 o_rows[4];
+        for (int k = 0; k < 4; k++) o_rows[k] = _mm256_broadcast_ps(&o[k].v);
+        for (int i = 0; i < 4; i += 2) {
+          __m256 a = _mm256_insertf128_ps(_mm256_castps128_ps256(d[i].v), d[i + 1].v, 1);
+          __m256 r = _mm256_mul_ps(_mm256_permute_ps(a, 0x00), o_rows[0]);
+          r = _mm256_add_ps(r, _mm256_mul_ps(_mm256_permute_ps(a, 0x55), o_rows[1]));
+          r = _mm256_add_ps(r, _mm256_mul_ps(_mm256_permute_ps(a, 0xaa), o_rows[2]));
+          r = _mm256_add_ps(r, _mm256_mul_ps(_mm256_permute_ps(a, 0xff), o_rows[3]));
+          ret[i].v = _mm256_castps256_ps128(r);
+          ret[i + 1].v = _mm256_extractf128_ps(r, 1);
+        }
+        return ret;
+      }
+#endif
+      for (int i = 0; i < 4; i++) {
+        __m128 a = d[i].v;
+        __m128 r = _mm_mul_ps(_mm_shuffle_ps(a, a, 0x00), o[0].v);
+        r = _mm_add_ps(r, _mm_mul_ps(_mm_shuffle_ps(a, a, 0x55), o[1].v));
+        r = _mm_add_ps(r, _mm_mul_ps(_mm_shuffle_ps(a, a, 0xaa), o[2].v));
+        r = _mm_add_ps(r, _mm_mul_ps(_mm_shuffle_ps(a, a, 0xff), o[3].v));
+        ret[i].v = r;
+      }
+      return ret;
+    }
+#endif
     for (int i = 0; i < kDim; i++) {
       for (int j = 0; j < kDim; j++) {
         T tmp = 0;
@@ -959,8 +1112,90 @@ T Determinant(const MatrixND<4, T, ISE> &m) {
   return Dot1;
 }
 
+#if defined(MIN_SIMD_SSE)
+// Block-wise inverse via 2x2 adjugates, a 2x2 block is held as (m00, m01, m10, m11) in one register.
+// Inverting the transpose gives the transposed inverse, so this is independent of the storage order
+namespace detail {
+
+template <int x, int y, int z, int w>
+MIN_FORCE_INLINE __m128 Shuffle(__m128 a, __m128 b) {
+  return _mm_shuffle_ps(a, b, _MM_SHUFFLE(w, z, y, x));
+}
+
+template <int x, int y, int z, int w>
+MIN_FORCE_INLINE __m128 Swizzle(__m128 a) {
+  return _mm_shuffle_ps(a, a, _MM_SHUFFLE(w, z, y, x));
+}
+
+// A * B
+MIN_FORCE_INLINE __m128 Mat2Mul(__m128 a, __m128 b) {
+  return _mm_add_ps(_mm_mul_ps(a, Swizzle<0, 3, 0, 3>(b)),
+                    _mm_mul_ps(Swizzle<1, 0, 3, 2>(a), Swizzle<2, 1, 2, 1>(b)));
+}
+
+// adj(A) * B
+MIN_FORCE_INLINE __m128 Mat2AdjMul(__m128 a, __m128 b) {
+  return _mm_sub_ps(_mm_mul_ps(Swizzle<3, 3, 0, 0>(a), b),
+                    _mm_mul_ps(Swizzle<1, 1, 2, 2>(a), Swizzle<2, 3, 0, 1>(b)));
+}
+
+// A * adj(B)
+MIN_FORCE_INLINE __m128 Mat2MulAdj(__m128 a, __m128 b) {
+  return _mm_sub_ps(_mm_mul_ps(a, Swizzle<3, 0, 3, 0>(b)),
+                    _mm_mul_ps(Swizzle<1, 0, 3, 2>(a), Swizzle<2, 1, 2, 1>(b)));
+}
+
+MIN_FORCE_INLINE void InverseSimd(const __m128 m[4], __m128 ret[4]) {
+  __m128 a = _mm_movelh_ps(m[0], m[1]);
+  __m128 b = _mm_movehl_ps(m[1], m[0]);
+  __m128 c = _mm_movelh_ps(m[2], m[3]);
+  __m128 d = _mm_movehl_ps(m[3], m[2]);
+  // (|A|, |B|, |C|, |D|)
+  __m128 det_sub = _mm_sub_ps(_mm_mul_ps(Shuffle<0, 2, 0, 2>(m[0], m[2]), Shuffle<1, 3, 1, 3>(m[1], m[3])),
+                              _mm_mul_ps(Shuffle<1, 3, 1, 3>(m[0], m[2]), Shuffle<0, 2, 0, 2>(m[1], m[3])));
+  __m128 det_a = Swizzle<0, 0, 0, 0>(det_sub);
+  __m128 det_b = Swizzle<1, 1, 1, 1>(det_sub);
+  __m128 det_c = Swizzle<2, 2, 2, 2>(det_sub);
+  __m128 det_d = Swizzle<3, 3, 3, 3>(det_sub);
+  __m128 d_c = Mat2AdjMul(d, c);
+  __m128 a_b = Mat2AdjMul(a, b);
+  // Adjugates of the four blocks of the inverse
+  __m128 x = _mm_sub_ps(_mm_mul_ps(det_d, a), Mat2Mul(b, d_c));
+  __m128 w = _mm_sub_ps(_mm_mul_ps(det_a, d), Mat2Mul(c, a_b));
+  __m128 y = _mm_sub_ps(_mm_mul_ps(det_b, c), Mat2MulAdj(d, a_b));
+  __m128 z = _mm_sub_ps(_mm_mul_ps(det_c, b), Mat2MulAdj(a, d_c));
+  // |M| = |A||D| + |B||C| - tr(adj(A)B adj(D)C)
+  __m128 tr = _mm_mul_ps(a_b, Swizzle<0, 2, 1, 3>(d_c));
+  tr = _mm_add_ps(tr, _mm_movehl_ps(tr, tr));
+  tr = _mm_add_ss(tr, Swizzle<1, 1, 1, 1>(tr));
+  __m128 det = _mm_sub_ps(_mm_add_ps(_mm_mul_ps(det_a, det_d), _mm_mul_ps(det_b, det_c)),
+                          Swizzle<0, 0, 0, 0>(tr));
+  __m128 inv_det = _mm_div_ps(_mm_setr_ps(1.f, -1.f, -1.f, 1.f), det);
+  x = _mm_mul_ps(x, inv_det);
+  y = _mm_mul_ps(y, inv_det);
+  z = _mm_mul_ps(z, inv_det);
+  w = _mm_mul_ps(w, inv_det);
+  // Undo the adjugate while scattering the blocks back into rows
+  ret[0] = Shuffle<3, 1, 3, 1>(x, y);
+  ret[1] = Shuffle<2, 0, 2, 0>(x, y);
+  ret[2] = Shuffle<3, 1, 3, 1>(z, w);
+  ret[3] = Shuffle<2, 0, 2, 0>(z, w);
+}
+
+}
+#endif
+
 template <typename T, InstSetExt ISE>
 MatrixND<4, T, ISE> Inverse(const MatrixND<4, T, ISE> &m) {
+#if defined(MIN_SIMD_SSE)
+  if constexpr (VectorND<4, T, ISE>::kSimd) {
+    const __m128 rows[4] = {m[0].v, m[1].v, m[2].v, m[3].v};
+    __m128 inv[4];
+    detail::InverseSimd(rows, inv);
+    return MatrixND<4, T, ISE>(VectorND<4, T, ISE>(inv[0]), VectorND<4, T, ISE>(inv[1]),
+                               VectorND<4, T, ISE>(inv[2]), VectorND<4, T, ISE>(inv[3]));
+  }
+#endif
   // This function is copied from GLM
   /*
   ================================================================================
@@ -69,6 +69,41 @@ MIN_FORCE_INLINE Float InverseGammaCorrect(Float value) {
   return std::pow((value + 0.055f) * 1.f / 1.055f, (Float)2.4f);
 }
 
+MIN_FORCE_INLINE Float SafeSqrt(Float x) { return std::sqrt(std::max((Float)0, x)); }
+
+MIN_FORCE_INLINE Float SafeACos(Float x) { return std::acos(Clamp(x, (Float)-1, (Float)1)); }
+
+// Inverse error function, Giles' single precision approximation
+MIN_FORCE_INLINE Float ErfInv(Float x) {
+  Float w, p;
+  x = Clamp(x, (Float)-.99999f, (Float).99999f);
+  w = -std::log((1 - x) * (1 + x));
+  if (w < 5) {
+    w = w - 2.5f;
+    p = 2.81022636e-08f;
+    p = 3.43273939e-07f + p * w;
+    p = -3.5233877e-06f + p * w;
+    p = -4.39150654e-06f + p * w;
+    p = 0.00021858087f + p * w;
+    p = -0.00125372503f + p * w;
+    p = -0.00417768164f + p * w;
+    p = 0.246640727f + p * w;
+    p = 1.50140941f + p * w;
+  } else {
+    w = std::sqrt(w) - 3;
+    p = -0.000200214257f;
+    p = 0.000100950558f + p * w;
+    p = 0.00134934322f + p * w;
+    p = -0.00367342844f + p * w;
+    p = 0.00573950773f + p * w;
+    p = -0.0076224613f + p * w;
+    p = 0.00943887047f + p * w;
+    p = 1.00167406f + p * w;
+    p = 2.83297682f + p * w;
+  }
+  return p * x;
+}
+
 MIN_FORCE_INLINE Float Radians(Float deg) { return (kPi / 180) * deg; }
 
 MIN_FORCE_INLINE Float Degrees(Float rad) { return (180 / kPi) * rad; }
@@ -10,12 +10,15 @@ class AOIntegrator : public SampleRenderer {
     SampleRenderer::initialize(json);
     n_samples = Value(json, "n_samples", 64);
   }
-  virtual Spectrum Li(const Ray &ray, const std::shared_ptr<Scene> &scene, Sampler &sampler) {
+  virtual Spectrum Li(const RayDifferential &ray, const std::shared_ptr<Scene> &scene, Sampler &sampler,
+                      MemoryArena &arena) {
     SurfaceIntersection isect;
     Spectrum L(0);
     if (scene->Intersect(ray, isect)) {
+      Point2f *u = arena.Alloc<Point2f>(n_samples, false);
+      sampler.Get2DArray(u, n_samples);
       for (int i = 0; i < n_samples; i++) {
-        Vector3f wi = CosineSampleHemisphere(sampler.Get2D());
+        Vector3f wi = CosineSampleHemisphere(u[i]);
         Float pdf = std::abs(wi.z) * kInvPi;
         wi = isect.ToWorld(wi);
         if (!scene->IntersectP(isect.SpawnRay(wi))) {
@@ -5,7 +5,8 @@ namespace min {
 
 class NormalsIntegrator : public SampleRenderer {
  public:
-  virtual Spectrum Li(const Ray &ray, const std::shared_ptr<Scene> &scene, Sampler &sampler) {
+  virtual Spectrum Li(const RayDifferential &ray, const std::shared_ptr<Scene> &scene, Sampler &sampler,
+                      MemoryArena &arena) {
     SurfaceIntersection isect;
     if (!scene->Intersect(ray, isect))
       return Spectrum(0.0f);
@@ -1,5 +1,5 @@
 #include "sample.h"
-#include <min/visual/distribution.h>
+#include <min/visual/light_sampler.h>
 #include <min/visual/sampling.h>
 
 namespace min {
@@ -8,129 +8,92 @@ class PathTracer : public SampleRenderer {
 
   int max_depth = 5;
   Float threshold = 1.0;
+  std::shared_ptr<LightSampler> light_sampler;
 
-  Spectrum UniformSampleOneLight(const SurfaceIntersection &it, const std::shared_ptr<Scene> &scene,
-      Sampler &sampler, const Distribution1D *light_distrib = nullptr) const {
-    int n_lights = int(scene->lights.size());
-    if (n_lights == 0) return Spectrum(0);
-    int light_num;
-    Float light_pdf;
-    if (light_distrib) {
-      light_num = light_distrib->SampleDiscrete(sampler.Get1D(), &light_pdf);
-      if (light_pdf == 0) return Spectrum(0);
-    } else {
-      light_num = std::min((int)(sampler.Get1D() * n_lights), n_lights - 1);
-      light_pdf = 1.0 / n_lights;
-    }
-    const std::shared_ptr<Light> &light = scene->lights[light_num];
+  // Next event estimation, emitters reached by the BSDF-sampled continuation get the other MIS half
+  Spectrum SampleLd(const SurfaceIntersection &it, const std::shared_ptr<Scene> &scene,
+      Sampler &sampler) const {
+    Float light_pmf;
+    const Light *light = light_sampler->Sample(it, sampler.Get1D(), &light_pmf);
     Point2f u_light = sampler.Get2D();
-    Point2f u_scattering = sampler.Get2D();
-    return EstimateDirect(scene, it, u_scattering, u_light, *light, sampler) / light_pdf;
-  }
+    if (!light || light_pmf == 0) return Spectrum(0);
 
-  Spectrum EstimateDirect(const std::shared_ptr<Scene> &scene, const SurfaceIntersection &it,
-      const Point2f u_scattering, const Point2f u_light,
-      const Light &light,Sampler &sampler, bool specular = false) const {
-    BxDF::Type bsdf_flags = specular ? BxDF::Type::kAll : BxDF::Type::kAllButSpecular;
-    Spectrum Ld(0);
-    Vector3 wi;
-    Float light_pdf = 0, scattering_pdf = 0;
     LightSample light_sample;
     VisibilityTester tester;
-    light.SampleLi(u_light, it, light_sample, tester);
-    wi = light_sample.wi;
-    light_pdf = light_sample.pdf;
-    Spectrum Li = light_sample.li;
-    if (light_pdf > 0 && !IsBlack(Li)) {
-      // Compute BSDF
-      Spectrum f;
-      f = it.bsdf->Evaluate(it.wo, wi, bsdf_flags)
-          * AbsDot(wi, it.shading_frame.n);
-      scattering_pdf = it.bsdf->Pdf(it.wo, wi, bsdf_flags);
-      if (!IsBlack(f)) {
-        if (!tester.Unoccluded(scene)) {
-          Li = Spectrum(0);
-        }
-        // Light contribution
-        if (!IsBlack(Li)) {
-          if (IsDeltaLight(light.flags)) {
-            Ld += f * Li / light_sample.pdf;
-          } else {
-            Float weight = PowerHeuristic(1, light_pdf, 1, scattering_pdf);
-            Ld += f * Li* weight / light_pdf;
-          }
-        }
-      }
-    }
+    light->SampleLi(u_light, it, light_sample, tester);
+    if (light_sample.pdf == 0 || IsBlack(light_sample.li)) return Spectrum(0);
+    Vector3 wi = light_sample.wi;
+    Spectrum f = it.bsdf->Evaluate(it.wo, wi) * AbsDot(wi, it.shading_frame.n);
+    if (IsBlack(f) || !tester.Unoccluded(scene)) return Spectrum(0);
 
-    // Sample BSDF with MIS
-    if (!IsDeltaLight(light.flags)) {
-      Spectrum f;
-      bool sampled_specular = false;
-      BSDFSample bsdf_sample;
-      it.bsdf->Sample(u_scattering, it.wo, bsdf_sample, bsdf_flags);
-      wi = bsdf_sample.wi;
-      scattering_pdf = bsdf_sample.pdf;
-      f = bsdf_sample.f * AbsDot(wi, it.shading_frame.n);
-      sampled_specular = (bsdf_sample.sampled_type & BxDF::Type::kSpecular) != 0;
-      if (!IsBlack(f) && scattering_pdf > 0) {
-        Float weight = 1;
-        if (!sampled_specular) {
-          Float light_pdf = light.PdfLi(it, wi);
-          if (light_pdf == 0) return Ld;
-          weight = PowerHeuristic(1, scattering_pdf, 1, light_pdf);
-        }
-        SurfaceIntersection light_isect;
-        Ray ray = it.SpawnRay(wi);
-        bool found_intersection = scene->Intersect(ray, light_isect);
-        Spectrum Li(0);
-        if (found_intersection) {
-          if (light_isect.shape->area_light.get() == &light) {
-            Li = light.L(light_isect, -wi);
-          }
-        } else {
-          Li = light.Le(ray);
-        }
-        if (!IsBlack(Li)) Ld += f * Li * weight / scattering_pdf;
-      }
-    }
-    return Ld;
+    Float light_pdf = light_pmf * light_sample.pdf;
+    if (IsDeltaLight(light->flags)) return f * light_sample.li / light_pdf;
+    Float scattering_pdf = it.bsdf->Pdf(it.wo, wi);
+    Float weight = PowerHeuristic(1, light_pdf, 1, scattering_pdf);
+    return f * light_sample.li * weight / light_pdf;
+  }
+
+  // Weight for emission found by BSDF sampling from prev_isect, the light strategy's share goes to SampleLd
+  template <typename Target>
+  Float EmitterMISWeight(const Light *light, const Intersection &prev_isect, const Target &target,
+      Float scattering_pdf) const {
+    Float light_pdf = light_sampler->Pmf(prev_isect, light) * light->PdfLi(prev_isect, target);
+    return PowerHeuristic(1, scattering_pdf, 1, light_pdf);
   }
  public:
-  Spectrum Li(const Ray &r, const std::shared_ptr<Scene> &scene, Sampler &sampler) override {
+  void initialize(const Json &json) override {
+    SampleRenderer::initialize(json);
+    std::string light_sampler_type = "bvh";
+    if (json.contains("light_sampler"))
+      light_sampler_type = json["light_sampler"]["type"].get<std::string>();
+    light_sampler = CreateInstance<LightSampler>(light_sampler_type, GetProps(AtOrEmpty(json, "light_sampler")));
+  }
+  void Preprocess() override {
+    light_sampler->Build(scene->lights);
+  }
+  Spectrum Li(const RayDifferential &r, const std::shared_ptr<Scene> &scene, Sampler &sampler,
+              MemoryArena &arena) override {
     Spectrum L(0), beta(1);
-    Ray ray(r);
+    RayDifferential ray(r);
+    // State of the last scattering vertex, emission found along ray is MIS-weighted against it
     bool specular = false;
+    Float scattering_pdf = 0;
+    Intersection prev_isect;
     int depth;
     Float eta_scale = 1.0f;
     for (depth = 0;;++depth) {
       SurfaceIntersection isect;
       bool found_intersection = scene->Intersect(ray, isect);
-      if (depth == 0 || specular) {
-        if (found_intersection) {
-          if (isect.shape->area_light) {
-            L += beta * isect.shape->area_light->L(isect, -ray.d);
-          }
-        } else {
-          for (const auto &light : scene->infinite_lights) {
-            L += beta * light->Le(ray);
-          }
+      if (!found_intersection) {
+        for (const auto &light : scene->infinite_lights) {
+          Spectrum Le = light->Le(ray);
+          if (IsBlack(Le)) continue;
+          if (depth == 0 || specular) L += beta * Le;
+          else L += beta * Le * EmitterMISWeight(light.get(), prev_isect, ray.d, scattering_pdf);
+        }
+        break;
+      }
+      if (const Light *area_light = isect.shape->area_light.get()) {
+        Spectrum Le = area_light->L(isect, -ray.d);
+        if (!IsBlack(Le)) {
+          if (depth == 0 || specular) L += beta * Le;
+          else L += beta * Le * EmitterMISWeight(area_light, prev_isect, isect, scattering_pdf);
         }
       }
-      if (!found_intersection || depth >= max_depth) break;
-      isect.ComputeScatteringEvents();
+      if (depth >= max_depth) break;
+      isect.ComputeDifferentials(ray);
+      isect.ComputeScatteringEvents(arena);
       if (!isect.bsdf) {
-        ray = isect.SpawnRay(ray.d);
+        ray = isect.SpawnRayDifferential(ray, ray.d, BxDF::Type(BxDF::kSpecular | BxDF::kTransmission));
         depth--;
         continue;
       }
-      const Distribution1D *distrib = nullptr;
       // Sample from lights
       if (isect.bsdf->NumComponents(BxDF::Type(BxDF::Type::kAllButSpecular)) > 0) {
-        Spectrum Ld = beta * UniformSampleOneLight(isect, scene, sampler, distrib);
+        Spectrum Ld = beta * SampleLd(isect, scene, sampler);
         L += Ld;
       }
-      // Sample BSDF
+      // Sample BSDF, the same direction continues the path
       Vector3 wo = -ray.d, wi;
       Float pdf;
       BSDFSample bsdf_sample;
@@ -141,11 +104,13 @@ class PathTracer : public SampleRenderer {
       if (IsBlack(f) || pdf == 0.0f) break;
       beta *= f * AbsDot(wi, isect.shading_frame.n) / pdf;
       specular = (bsdf_sample.sampled_type & BxDF::Type::kSpecular) != 0;
+      scattering_pdf = pdf;
+      prev_isect = isect;
       if ((bsdf_sample.sampled_type & BxDF::Type::kSpecular) && (bsdf_sample.sampled_type & BxDF::Type::kTransmission)) {
         Float eta = isect.bsdf->eta;
         eta_scale *= (Dot(wo, isect.geo_frame.n) > 0) ? (eta * eta) : 1 / (eta * eta);
       }
-      ray = isect.SpawnRay(wi);
+      ray = isect.SpawnRayDifferential(ray, wi, bsdf_sample.sampled_type);
       // Russian roulette
       Spectrum rr = beta * eta_scale;
       if (beta.MaxComp() < threshold && depth > 3) {
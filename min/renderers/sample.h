@@ -7,6 +7,7 @@
 #include <min/common/json.h>
 #include <min/gui/preview_gui.h>
 #include <min/common/parallel.h>
+#include <min/common/memory.h>
 
 namespace min {
 
@@ -16,7 +17,10 @@ class SampleRenderer : public Renderer {
   void initialize(const Json &json) override {
     sampler = CreateInstance<Sampler>(json["sampler"]["type"],GetProps(json.at("sampler")));
   }
+  // Called once the scene is set, before any sample is taken
+  virtual void Preprocess() {}
   void Render() override {
+    Preprocess();
     auto camera = scene->camera;
     auto film = camera->film;
     auto sample_bounds = film->GetSampleBounds();
@@ -28,6 +32,8 @@ class SampleRenderer : public Renderer {
     std::thread render_thread([&] {
       MIN_INFO("Rendering .. ");
       ParallelFor2D([&](Vector2i tile) {
+        // Scratch memory for BSDFs, kept per worker thread and recycled after every sample
+        thread_local MemoryArena arena;
         auto tile_sampler = sampler->Clone();
         int x0 = sample_bounds.pmin.x + tile.x * kTileSize;
         int x1 = std::min(x0 + kTileSize, sample_bounds.pmax.x);
@@ -38,13 +44,21 @@ class SampleRenderer : public Renderer {
         auto film_tile = film->GetFilmTile(tile_bounds);
         for (Point2i pixel : tile_bounds) {
           for (int s = 0; s < tile_sampler->spp; s++) {
-            tile_sampler->StartPixel(pixel);
-            Ray ray;
-            auto pfilm = (Point2f)pixel + sampler->Get2D();
-            auto ray_weight = camera->GenerateRay(pfilm,sampler->Get2D(), sampler->Get1D(), ray);
+            tile_sampler->StartPixelSample(pixel, s);
+            RayDifferential ray;
+            Point2f pfilm;
+            Float filter_weight = 1;
+            if (film->importance_sample_filter)
+              pfilm = (Point2f)pixel + Vector2f(0.5f, 0.5f) + film->SampleFilter(tile_sampler->Get2D(), &filter_weight);
+            else
+              pfilm = (Point2f)pixel + tile_sampler->Get2D();
+            Point2f plens = tile_sampler->Get2D();
+            Float time = tile_sampler->Get1D();
+            auto ray_weight = camera->GenerateRayDifferential(pfilm, plens, time, ray);
+            ray.ScaleDifferentials(1 / std::sqrt((Float)tile_sampler->spp));
             //MIN_DEBUG("o : {} d : {}", ray.o.ToString(), ray.d.ToString());
             Spectrum L(0.f);
-            if (ray_weight > 0) L = Li(ray, scene, *tile_sampler);
+            if (ray_weight > 0) L = Li(ray, scene, *tile_sampler, arena);
             if (L.Abnormal()) {
               MIN_WARN("Not a number radiance value returned for pixel ({}, {}), sample {}. Setting to black.",
                        pixel.x, pixel.y, s);
@@ -58,7 +72,11 @@ class SampleRenderer : public Renderer {
                        pixel.x, pixel.y, s);
               L = Spectrum(0.f);
             }
-            film_tile->AddSample(pfilm, L, ray_weight);
+            if (film->importance_sample_filter)
+              film_tile->AddPixelSample(pixel, L * ray_weight, filter_weight);
+            else
+              film_tile->AddSample(pfilm, L, ray_weight);
+            arena.Reset();
           }
         }
         film->MergeFilmTile(std::move(film_tile));
@@ -71,7 +89,8 @@ class SampleRenderer : public Renderer {
     film->WriteImage();
   }
 
-  virtual Spectrum Li(const Ray &ray, const std::shared_ptr<Scene> &scene, Sampler &sampler) = 0;
+  virtual Spectrum Li(const RayDifferential &ray, const std::shared_ptr<Scene> &scene, Sampler &sampler,
+                      MemoryArena &arena) = 0;
 };
 
 
@@ -0,0 +1,82 @@
+#include <min/visual/sampler.h>
+#include <min/visual/lowdiscrepancy.h>
+#include <min/visual/bluenoise.h>
+
+namespace min {
+
+// Progressive multi-jittered (0, 2) sequences. Every power of two prefix of a pattern is stratified over
+// all elementary intervals, so any prefix of the samples of a pixel is well distributed.
+// Patterns are Owen scrambled 2D Sobol points, which are pmj02, precomputed once as 32 bit fixed point.
+// Each pixel and dimension picks a pattern and applies a random digital shift, which keeps the strata.
+// With blue_noise all pixels share the pattern and shift of a dimension, and every pixel XORs blue noise
+// onto the shift. That is again a digital shift, so the strata are kept and only trade places in a blue
+// noise pattern between neighbouring pixels.
+class PMJ02Sampler : public Sampler {
+  static constexpr int kSets = 64;
+  // kSets patterns of count points, x and y interleaved
+  std::shared_ptr<const std::vector<uint32_t>> patterns;
+  int count = 0;
+  bool blue_noise = false;
+  int seed = 0;
+  Point2i pixel;
+  int sample_index = 0;
+  int dimension = 0;
+
+  const uint32_t *Point(uint64_t hash) const {
+    int set = int(hash % kSets);
+    return &(*patterns)[2 * (size_t(set) * count + sample_index % count)];
+  }
+  uint64_t PixelKey() const {
+    return blue_noise ? 0 : PackPixel(pixel);
+  }
+  // Digital shift of the fixed point value, further shifted by blue noise when enabled
+  Float Randomize(uint32_t v, uint32_t shift, int dim) const {
+    if (blue_noise) shift ^= BlueNoiseBits(dim, pixel);
+    return std::min<Float>((v ^ shift) * 0x1p-32f, kOneMinusEpsilon);
+  }
+ public:
+  void initialize(const Json &json) override {
+    seed = Value(json, "seed", 0);
+    spp = Value(json, "spp", 1);
+    blue_noise = Value(json, "blue_noise", false);
+    count = RoundUpPow2(int(spp));
+    MIN_WARN_UNLESS(IsPowerOf2(spp), "PMJ02 sampler is stratified at powers of two spp, got {}", spp);
+    auto table = std::make_shared<std::vector<uint32_t>>(size_t(2) * kSets * count);
+    for (int set = 0; set < kSets; ++set) {
+      OwenScrambler sx(uint32_t(MixBits(2 * set))), sy(uint32_t(MixBits(2 * set + 1)));
+      for (int i = 0; i < count; ++i) {
+        uint32_t *p = &(*table)[2 * (size_t(set) * count + i)];
+        p[0] = sx(ReverseBits32(uint32_t(i)));
+        uint32_t y = 0;
+        for (uint32_t a = uint32_t(i), k = 0; a != 0; a >>= 1U, ++k)
+          if (a & 1U) y ^= kSobolMatrix1[k];
+        p[1] = sy(y);
+      }
+    }
+    patterns = std::move(table);
+  }
+  void StartPixelSample(const Point2i &p, int index) override {
+    pixel = p;
+    sample_index = index;
+    dimension = 0;
+  }
+  Float Get1D() override {
+    int dim = dimension++;
+    uint64_t hash = Hash(PixelKey(), dim, seed);
+    return Randomize(Point(hash)[0], uint32_t(hash >> 32U), dim);
+  }
+  Point2f Get2D() override {
+    int dim = dimension;
+    dimension += 2;
+    uint64_t hash = Hash(PixelKey(), dim, seed);
+    const uint32_t *p = Point(hash);
+    uint64_t shift = MixBits(hash);
+    return Point2f(Randomize(p[0], uint32_t(shift), dim), Randomize(p[1], uint32_t(shift >> 32U), dim + 1));
+  }
+  std::unique_ptr<Sampler> Clone() override {
+    return std::make_unique<PMJ02Sampler>(*this);
+  }
+};
+MIN_IMPLEMENTATION(Sampler, PMJ02Sampler, "pmj02")
+
+}
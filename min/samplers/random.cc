@@ -3,15 +3,19 @@
 
 namespace min {
 
+// Independent uniform samples, every pixel owns a PCG stream and sample i starts at offset i * 2^16
 class RandomSampler : public Sampler {
   Rng rng;
+  Rng8 batch;
+  int seed = 0;
  public:
   void initialize(const Json &json) override {
-    int seed = Value(json, "seed", 0);
+    seed = Value(json, "seed", 0);
     spp = Value(json, "spp", 1);
   }
-  void StartPixel(const Point2i &p) override {
-
+  void StartPixelSample(const Point2i &p, int sample_index) override {
+    rng.SetSequence(Hash(uint32_t(p.x), uint32_t(p.y), uint32_t(seed)), MixBits(uint64_t(seed)));
+    rng.Advance(int64_t(sample_index) * 65536);
   }
   Float Get1D() override {
     return rng.UniformFloat();
@@ -19,9 +23,20 @@ class RandomSampler : public Sampler {
   Point2f Get2D() override {
     return Point2f(Get1D(), Get1D());
   }
+  void Get2DArray(Point2f *u, int n) override {
+    // Lanes are seeded from the pixel stream, so the batch is as deterministic as Get2D
+    uint64_t state = (uint64_t(rng.UniformUInt32()) << 32U) | rng.UniformUInt32();
+    batch.Seed(state, rng.UniformUInt32());
+    float values[2 * Rng8::kLanes];
+    for (int i = 0; i < n; i += Rng8::kLanes) {
+      batch.UniformFloats(values, 2 * Rng8::kLanes);
+      for (int j = 0; j < Rng8::kLanes && i + j < n; ++j) u[i + j] = Point2f(values[2 * j], values[2 * j + 1]);
+    }
+  }
   std::unique_ptr<Sampler> Clone() override {
     std::unique_ptr<RandomSampler> cloned(new RandomSampler());
     cloned->rng = rng;
+    cloned->seed = seed;
     cloned->spp = spp;
     return std::move(cloned);
   }
@@ -29,4 +44,3 @@ class RandomSampler : public Sampler {
 MIN_IMPLEMENTATION(Sampler, RandomSampler, "random")
 
 }
-
@@ -0,0 +1,69 @@
+#include <min/visual/sampler.h>
+#include <min/visual/lowdiscrepancy.h>
+#include <min/visual/bluenoise.h>
+
+namespace min {
+
+// Padded Sobol: every 1D or 2D request draws from the first two Sobol dimensions, decorrelated by a
+// per pixel and dimension permutation of the sample index and Owen scrambling.
+// With blue_noise every pixel shares the randomization and XORs blue noise onto the scrambled points,
+// a digital shift which keeps their stratification and pushes the error of low sample counts to high
+// screen space frequencies.
+class SobolSampler : public Sampler {
+  enum class Randomization { kNone, kOwen };
+  Randomization randomize = Randomization::kOwen;
+  bool blue_noise = false;
+  int seed = 0;
+  Point2i pixel;
+  int sample_index = 0;
+  int dimension = 0;
+
+  // Point a of Sobol dimension sobol_dim for sampler dimension dim
+  Float SampleDimension(int sobol_dim, uint32_t a, uint32_t hash, int dim) const {
+    uint32_t shift = blue_noise ? BlueNoiseBits(dim, pixel) : 0;
+    if (randomize == Randomization::kNone)
+      return SobolSample(a, sobol_dim, [=](uint32_t v) { return v ^ shift; });
+    FastOwenScrambler owen(hash);
+    return SobolSample(a, sobol_dim, [=](uint32_t v) { return owen(v) ^ shift; });
+  }
+  uint64_t PixelKey() const {
+    return blue_noise ? 0 : PackPixel(pixel);
+  }
+ public:
+  void initialize(const Json &json) override {
+    seed = Value(json, "seed", 0);
+    spp = Value(json, "spp", 1);
+    auto randomization = Value<std::string>(json, "randomization", "owen");
+    if (randomization == "none") randomize = Randomization::kNone;
+    else if (randomization != "owen") MIN_ERROR("Unknown Sobol randomization \"{}\"", randomization);
+    blue_noise = Value(json, "blue_noise", false);
+    MIN_WARN_UNLESS(IsPowerOf2(spp), "Sobol sampler converges best with a power of two spp, got {}", spp);
+  }
+  void StartPixelSample(const Point2i &p, int index) override {
+    pixel = p;
+    sample_index = index;
+    dimension = 0;
+  }
+  Float Get1D() override {
+    int dim = dimension++;
+    uint64_t hash = Hash(PixelKey(), dim, seed);
+    int index = PermutationElement(sample_index, uint32_t(spp), uint32_t(hash));
+    return SampleDimension(0, index, uint32_t(hash >> 32U), dim);
+  }
+  Point2f Get2D() override {
+    int dim = dimension;
+    dimension += 2;
+    uint64_t hash = Hash(PixelKey(), dim, seed);
+    int index = PermutationElement(sample_index, uint32_t(spp), uint32_t(hash));
+    // Scramble seeds independent of the permutation seed
+    uint64_t scramble = MixBits(hash);
+    return Point2f(SampleDimension(0, index, uint32_t(scramble), dim),
+                   SampleDimension(1, index, uint32_t(scramble >> 32U), dim + 1));
+  }
+  std::unique_ptr<Sampler> Clone() override {
+    return std::make_unique<SobolSampler>(*this);
+  }
+};
+MIN_IMPLEMENTATION(Sampler, SobolSampler, "sobol")
+
+}
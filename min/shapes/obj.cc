@@ -1,6 +1,7 @@
 #include <min/visual/aggregate.h>
 #include <min/visual/material.h>
 #include <min/visual/light.h>
+#include <min/visual/resource_cache.h>
 #include <tiny_obj_loader.h>
 #include <fstream>
 #include <sstream>
@@ -78,6 +79,92 @@ class Obj : public Aggregate {
       return hash;
     }
   };
+
+  // Positions and normals are baked in world space, so the transform is part of the mesh
+  static std::shared_ptr<const TriangleMesh> LoadMesh(const fs::path &filename, const Transform &transform) {
+    MIN_DEBUG("Loading \"{}\" .. ", filename.string());
+    std::unique_ptr<Point3[]> positions;
+    std::unique_ptr<Normal3[]> normals;
+    std::unique_ptr<Point2[]> texcoords;
+    std::unique_ptr<int[]> vertex_indices;
+    tinyobj::attrib_t attrib;
+    std::vector<tinyobj::shape_t> shapes;
+
+    std::string warn;
+    std::string err;
+
+    bool ret = tinyobj::LoadObj(&attrib, &shapes, nullptr, &warn, &err, filename.string().c_str());
+    if (!warn.empty()) {
+      MIN_WARN("Warn: {}", warn);
+    }
+
+    if (!err.empty()) {
+      MIN_ERROR("Unable to open OBJ file {}: {}", filename.string(), err);
+    }
+
+    if (!ret) {
+      MIN_ERROR("Unable to open OBJ file {}!", filename.string());
+    }
+    int vertex_index = 0, num_triangles = 0, num_vertexs = 0;
+    bool count_tex = false, count_normal = false;
+    for (size_t s = 0; s < shapes.size(); s++) {
+      size_t index_offset = 0;
+      for (size_t f= 0; f < shapes[s].mesh.num_face_vertices.size(); f++) {
+        for (size_t v = 0; v < shapes[s].mesh.num_face_vertices[f]; v++) {
+          tinyobj::index_t idx = shapes[s].mesh.indices[index_offset + v];
+          if (idx.normal_index != -1) { count_normal = true; }
+          if (idx.texcoord_index != -1) { count_tex = true; }
+          num_vertexs++;
+        }
+        index_offset += shapes[s].mesh.num_face_vertices[f];
+        num_triangles++;
+      }
+    }
+    vertex_indices.reset(new int[num_vertexs]);
+    positions.reset(new Point3[num_vertexs]);
+    if (count_tex) texcoords.reset(new Point2[num_vertexs]);
+    if (count_normal) normals.reset(new Normal3[num_vertexs]);
+    // Loop over shapes
+    for (size_t s = 0; s < shapes.size(); s++) {
+      // Loop over faces(polygon)
+      size_t index_offset = 0;
+      for (size_t f = 0; f < shapes[s].mesh.num_face_vertices.size(); f++) {
+        int fv = shapes[s].mesh.num_face_vertices[f];
+
+        // Loop over vertices in the face.
+        for (size_t v = 0; v < fv; v++) {
+          // access to vertex
+          vertex_indices[vertex_index] = vertex_index;
+          tinyobj::index_t idx = shapes[s].mesh.indices[index_offset + v];
+          tinyobj::real_t vx = attrib.vertices[3 * idx.vertex_index + 0];
+          tinyobj::real_t vy = attrib.vertices[3 * idx.vertex_index + 1];
+          tinyobj::real_t vz = attrib.vertices[3 * idx.vertex_index + 2];
+          positions[vertex_index] = Point3(vx, vy, vz);
+          if (idx.normal_index != -1) {
+            tinyobj::real_t nx = attrib.normals[3 * idx.normal_index + 0];
+            tinyobj::real_t ny = attrib.normals[3 * idx.normal_index + 1];
+            tinyobj::real_t nz = attrib.normals[3 * idx.normal_index + 2];
+            normals[vertex_index] = Normal3(nx, ny, nz);
+          }
+          if (idx.texcoord_index != -1) {
+            tinyobj::real_t tx = attrib.texcoords[2 * idx.texcoord_index + 0];
+            tinyobj::real_t ty = attrib.texcoords[2 * idx.texcoord_index + 1];
+            texcoords[vertex_index] = Point2(tx, ty);
+          }
+          vertex_index++;
+        }
+        index_offset += fv;
+
+        // per-face material
+        shapes[s].mesh.material_ids[f];
+      }
+    }
+    MIN_DEBUG("Done. (V={}, F={})", num_vertexs, num_triangles);
+    transform.ToPoints(positions.get(), positions.get(), num_vertexs);
+    if (normals) transform.ToNormals(normals.get(), normals.get(), num_vertexs);
+    return std::make_shared<TriangleMesh>(Transform(), num_triangles, vertex_indices.get(), num_vertexs,
+        positions.get(), nullptr, normals.get(), texcoords.get(), nullptr);
+  }
  public:
   void initialize(const Json &json) override {
     typedef std::unordered_map<OBJVertex, uint32_t, OBJVertexHash> VertexMap;
@@ -180,100 +267,25 @@ class Obj : public Aggregate {
 //      for (uint32_t i = 0; i < local_vertices.size(); ++i)
 //        texcoords[i] = local_texcoords.at(local_vertices[i].uv - 1);
 //    }
-    MIN_DEBUG("Loading \"{}\" .. ", filename.string());
-    Point3 *positions = nullptr;
-    Normal3 *normals = nullptr;
-    Point2 *texcoords = nullptr;
-    int *vertex_indices = nullptr;
-    tinyobj::attrib_t attrib;
-    std::vector<tinyobj::shape_t> shapes;
-
-    std::string warn;
-    std::string err;
-
-    bool ret = tinyobj::LoadObj(&attrib, &shapes, nullptr, &warn, &err, filename.string().c_str());
-    if (!warn.empty()) {
-      MIN_WARN("Warn: {}", warn);
-    }
-
-    if (!err.empty()) {
-      MIN_ERROR("Unable to open OBJ file {}: {}", err);
-    }
-
-    if (!ret) {
-      MIN_ERROR("Unable to open OBJ file {}!", filename.string());
-    }
-    int vertex_index = 0, num_triangles = 0, num_vertexs = 0;
-    bool count_tex = false, count_normal = false;
-    for (size_t s = 0; s < shapes.size(); s++) {
-      size_t index_offset = 0;
-      for (size_t f= 0; f < shapes[s].mesh.num_face_vertices.size(); f++) {
-        for (size_t v = 0; v < shapes[s].mesh.num_face_vertices[f]; v++) {
-          tinyobj::index_t idx = shapes[s].mesh.indices[index_offset + v];
-          if (idx.normal_index != -1) { count_normal = true; }
-          if (idx.texcoord_index != -1) { count_tex = true; }
-          num_vertexs++;
-        }
-        index_offset += shapes[s].mesh.num_face_vertices[f];
-        num_triangles++;
-      }
-    }
-    vertex_indices = new int[num_vertexs];
-    positions = new Point3[num_vertexs];
-    if (count_tex) texcoords = new Point2[num_vertexs];
-    if (count_normal) normals = new Normal3[num_vertexs];
-    // Loop over shapes
-    for (size_t s = 0; s < shapes.size(); s++) {
-      // Loop over faces(polygon)
-      size_t index_offset = 0;
-      for (size_t f = 0; f < shapes[s].mesh.num_face_vertices.size(); f++) {
-        int fv = shapes[s].mesh.num_face_vertices[f];
-
-        // Loop over vertices in the face.
-        for (size_t v = 0; v < fv; v++) {
-          // access to vertex
-          vertex_indices[vertex_index] = vertex_index;
-          tinyobj::index_t idx = shapes[s].mesh.indices[index_offset + v];
-          tinyobj::real_t vx = attrib.vertices[3 * idx.vertex_index + 0];
-          tinyobj::real_t vy = attrib.vertices[3 * idx.vertex_index + 1];
-          tinyobj::real_t vz = attrib.vertices[3 * idx.vertex_index + 2];
-          positions[vertex_index] = transform.ToPoint(Point3(vx, vy, vz));
-          if (idx.normal_index != -1) {
-            tinyobj::real_t nx = attrib.normals[3 * idx.normal_index + 0];
-            tinyobj::real_t ny = attrib.normals[3 * idx.normal_index + 1];
-            tinyobj::real_t nz = attrib.normals[3 * idx.normal_index + 2];
-            normals[vertex_index] = transform.ToNormal(Normal3(nx, ny, nz));
-          }
-          if (idx.texcoord_index != -1) {
-            tinyobj::real_t tx = attrib.texcoords[2 * idx.texcoord_index + 0];
-            tinyobj::real_t ty = attrib.texcoords[2 * idx.texcoord_index + 1];
-            texcoords[vertex_index] = Point2(tx, ty);
-          }
-          vertex_index++;
-        }
-        index_offset += fv;
-
-        // per-face material
-        shapes[s].mesh.material_ids[f];
-      }
-    }
-    auto tri_shapes = CreateTriangleMesh(Transform(), Transform(), num_triangles, vertex_indices, num_vertexs,
-        positions, nullptr, normals, texcoords);
-    MIN_DEBUG("Done. (V={}, F={})", num_vertexs, num_triangles);
+    auto mesh = ResourceCache<TriangleMesh>::Get().GetOrCreate(
+        ResourceKey(filename, json.contains("transform") ? json.at("transform").dump() : ""),
+        [&] { return LoadMesh(filename, transform); });
+    auto tri_shapes = CreateTriangles(Transform(), Transform(), mesh);
     std::shared_ptr<Material> material = nullptr;
     if (json.contains("material")) {
       material = CreateInstance<Material>(json["material"]["type"], GetProps(json["material"]));
     } else {
       material = CreateInstance<Material>("diffuse", {});
     }
+    std::shared_ptr<Light> light = nullptr;
+    if (json.contains("light")) {
+      light = CreateInstance<Light>(json["light"]["type"], GetProps(json["light"]));
+      light->SetShapes(tri_shapes);
+      lights.emplace_back(light);
+    }
     for (auto &shape : tri_shapes) {
       shape->material = material;
-      if (json.contains("light")) {
-        auto light = CreateInstance<Light>(json["light"]["type"], GetProps(json["light"]));
-        shape->area_light = light;
-        light->SetShape(shape);
-        lights.emplace_back(light);
-      }
+      shape->area_light = light;
     }
     this->shapes = tri_shapes;
   }
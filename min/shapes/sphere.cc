@@ -16,6 +16,12 @@ class SphereInstance : public Aggregate {
     }
     auto shape = std::make_shared<Sphere>(Transform(), Transform(), radius, center);
     shape->material = material;
+    if (json.contains("light")) {
+      auto light = CreateInstance<Light>(json["light"]["type"], GetProps(json["light"]));
+      light->SetShape(shape);
+      shape->area_light = light;
+      lights.emplace_back(light);
+    }
     shapes.emplace_back(shape);
 
   }
@@ -2,12 +2,36 @@
 
 #include <min/visual/shape.h>
 #include <min/visual/intersection.h>
+#include <min/visual/sampling.h>
 
 namespace min {
 
 class Sphere : public Shape{
   const Float radius;
   const Point3f center;
+
+  // Nearest root of the ray/sphere quadratic in (0, tmax)
+  bool IntersectT(const Ray &ray, Float &t) const {
+    auto oc = ray.o - center;
+    auto a = Dot(ray.d, ray.d);
+    auto b = 2 * Dot(ray.d, oc);
+    auto c = Dot(oc, oc) - radius * radius;
+    auto delta = b * b - 4 * a * c;
+    if (delta < 0) {
+      return false;
+    }
+    auto t1 = (-b - std::sqrt(delta)) / (2 * a);
+    auto t2 = (-b + std::sqrt(delta)) / (2 * a);
+    if (t1 > 0 && t1 < ray.tmax) {
+      t = t1;
+      return true;
+    }
+    if (t2 > 0 && t2 < ray.tmax) {
+      t = t2;
+      return true;
+    }
+    return false;
+  }
  public:
   Sphere(const Transform &ObjectToWorld, const Transform &WorldToObject,
          Float radius, const Vector3f &center)
@@ -22,61 +46,84 @@ class Sphere : public Shape{
                     Point3f(center[0] + radius, center[1] + radius, center[2] + radius));
   }
   bool Intersect(const Ray &ray, SurfaceIntersection &isect) const override {
-    auto oc = ray.o - center;
-    auto a = Dot(ray.d, ray.d);
-    auto b = 2 * Dot(ray.d, oc);
-    auto c = Dot(oc, oc) - radius * radius;
-    auto delta = b * b - 4 * a * c;
-    if (delta < 0) {
-      return false;
-    }
-    auto t1 = (-b - std::sqrt(delta)) / (2 * a);
-    if (t1 >= ray.time) {
-      if (t1 < ray.tmax) {
-        isect.time = t1;
-        auto p = ray.o + t1 * ray.d;
-        isect.geo_frame = Frame(Normalize(p - center));
-        isect.shading_frame = isect.geo_frame;
-        isect.shape = this;
-        return true;
-      }
-    }
-    auto t2 = (-b + std::sqrt(delta)) / (2 * a);
-    if (t2 >= ray.time) {
-      if (t2 < ray.tmax) {
-        isect.time = t2;
-        auto p = ray.o + t2 * ray.d;
-        isect.geo_frame = Frame(Normalize(p - center));
-        isect.shading_frame = isect.geo_frame;
-        isect.shape = this;
-        return true;
-      }
-    }
-    return false;
+    Float t;
+    if (!IntersectT(ray, t)) return false;
+    Vector3 n = Normalize(ray.o + t * ray.d - center);
+    // Reproject onto the surface so the error bound holds
+    Point3 p = center + radius * n;
+    Float phi = std::atan2(n.y, n.x);
+    if (phi < 0) phi += 2 * kPi;
+    ShadingPoint sp;
+    sp.texcoords = Point2(phi * kInv2Pi, SafeACos(n.z) * kInvPi);
+    isect.p = p;
+    isect.error = Gamma(5) * Abs(p);
+    isect.wo = -ray.d;
+    isect.time = ray.time;
+    isect.sp = sp;
+    // Derivatives of p(u, v) for u = phi / 2pi, v = theta / pi
+    Float sintheta = std::sqrt(n.x * n.x + n.y * n.y);
+    Float cosphi = sintheta > 0 ? n.x / sintheta : 1, sinphi = sintheta > 0 ? n.y / sintheta : 0;
+    isect.dndu = 2 * kPi * Normal3f(-n.y, n.x, 0);
+    isect.dndv = kPi * Normal3f(n.z * cosphi, n.z * sinphi, -sintheta);
+    isect.dpdu = radius * isect.dndu;
+    isect.dpdv = radius * isect.dndv;
+    isect.geo_frame = Frame(n);
+    isect.shading_frame = isect.geo_frame;
+    isect.shape = this;
+    ray.tmax = t;
+    return true;
   }
 
   bool IntersectP(const Ray &ray) const override {
-    auto oc = ray.o - center;
-    auto a = Dot(ray.d, ray.d);
-    auto b = 2 * Dot(ray.d, oc);
-    auto c = Dot(oc, oc) - radius * radius;
-    auto delta = b * b - 4 * a * c;
-    if (delta < 0) {
-      return false;
-    }
-    auto t1 = (-b - std::sqrt(delta)) / (2 * a);
-    auto t2 = (-b + std::sqrt(delta)) / (2 * a);
-    return (t1 >= ray.time && t1 < ray.tmax) || (t2 >= ray.time && t2 < ray.tmax);
+    Float t;
+    return IntersectT(ray, t);
   }
 
   Float Area() const override {
     return 4 * kPi * radius * radius;
   }
+  void SamplePosition(const Point2f &u, SurfaceSample &sample) const override {
+    sample.normal = UniformSampleSphere(u);
+    sample.p = center + radius * sample.normal;
+  }
+  // Samples the cone of directions subtended by the sphere as seen from sample.ref
   void Sample(const Point2f &u, SurfaceSample &sample) const override {
+    Float dc2 = (sample.ref - center).LengthSquared();
+    if (dc2 <= radius * radius) {
+      SamplePosition(u, sample);
+      Vector3 wi = sample.p - sample.ref;
+      Float cos_light = AbsDot(sample.normal, Normalize(wi));
+      sample.pdf = cos_light > 0 ? wi.LengthSquared() / (cos_light * Area()) : 0;
+      if (std::isinf(sample.pdf)) sample.pdf = 0;
+      return;
+    }
+    Float dc = std::sqrt(dc2);
+    Float sin_theta_max2 = radius * radius / dc2;
+    Float cos_theta_max = SafeSqrt(1 - sin_theta_max2);
+    Float cos_theta = (1 - u[0]) + u[0] * cos_theta_max;
+    Float sin_theta = SafeSqrt(1 - cos_theta * cos_theta);
+    Float phi = u[1] * 2 * kPi;
 
+    // Angle alpha from the sphere center to the sampled point
+    Float ds = dc * cos_theta - SafeSqrt(radius * radius - dc2 * sin_theta * sin_theta);
+    Float cos_alpha = (dc2 + radius * radius - ds * ds) / (2 * dc * radius);
+    Float sin_alpha = SafeSqrt(1 - cos_alpha * cos_alpha);
+    Frame frame(Normalize(center - sample.ref));
+    sample.normal = -frame.ToWorld(Vector3(sin_alpha * std::cos(phi), sin_alpha * std::sin(phi), cos_alpha));
+    sample.p = center + radius * sample.normal;
+    sample.pdf = UniformConePdf(cos_theta_max);
+  }
+  Float Pdf(const Intersection &ref, const Vector3 &wi) const override {
+    Float dc2 = (ref.p - center).LengthSquared();
+    if (dc2 <= radius * radius) return Shape::Pdf(ref, wi);
+    return UniformConePdf(SafeSqrt(1 - radius * radius / dc2));
+  }
+  Float Pdf(const Intersection &ref, const SurfaceIntersection &isect) const override {
+    Float dc2 = (ref.p - center).LengthSquared();
+    if (dc2 <= radius * radius) return Shape::Pdf(ref, isect);
+    return UniformConePdf(SafeSqrt(1 - radius * radius / dc2));
   }
 };
 
 }
 
-
@@ -24,7 +24,7 @@ struct TriangleMesh {
 
     // Transform mesh vertices to world space
     p.reset(new Point3f[nVertices]);
-    for (int i = 0; i < nVertices; ++i) p[i] = ObjectToWorld.ToPoint(P[i]);
+    ObjectToWorld.ToPoints(P, p.get(), nVertices);
 
     // Copy _UV_, _N_, and _S_ vertex data, if present
     if (UV) {
@@ -33,19 +33,92 @@ struct TriangleMesh {
     }
     if (N) {
       n.reset(new Normal3f[nVertices]);
-      for (int i = 0; i < nVertices; ++i) n[i] = ObjectToWorld.ToNormal(N[i]);
+      ObjectToWorld.ToNormals(N, n.get(), nVertices);
     }
     if (S) {
       s.reset(new Vector3f[nVertices]);
-      for (int i = 0; i < nVertices; ++i) s[i] = ObjectToWorld.ToVector(S[i]);
+      ObjectToWorld.ToVectors(S, s.get(), nVertices);
     }
     if (fIndices)
       face_indices = std::vector<int>(fIndices, fIndices + nTriangles);
   }
 };
 
+// Watertight ray triangle test of pbrt, on a hit returns the parametric distance and barycentrics
+MIN_FORCE_INLINE bool WatertightIntersect(const Point3f &p0, const Point3f &p1, const Point3f &p2,
+                                          const Ray &ray, Float *t_hit, Float b[3]) {
+  Point3f p0t = p0 - Vector3f(ray.o);
+  Point3f p1t = p1 - Vector3f(ray.o);
+  Point3f p2t = p2 - Vector3f(ray.o);
+  auto rayd = Abs(ray.d);
+  int kz = rayd.x > rayd.y ? (rayd.x > rayd.z ? 0 : 2) : (rayd.y > rayd.z ? 1 : 2);
+  int kx = kz + 1;
+  if (kx == 3) kx = 0;
+  int ky = kx + 1;
+  if (ky == 3) ky = 0;
+  Vector3f d = Permute(ray.d, Vector3i(kx, ky, kz));
+  p0t = Permute(p0t, Vector3i(kx, ky, kz));
+  p1t = Permute(p1t, Vector3i(kx, ky, kz));
+  p2t = Permute(p2t, Vector3i(kx, ky, kz));
+  Float Sx = -d.x / d.z;
+  Float Sy = -d.y / d.z;
+  Float Sz = 1.f / d.z;
+  p0t.x += Sx * p0t.z;
+  p0t.y += Sy * p0t.z;
+  p1t.x += Sx * p1t.z;
+  p1t.y += Sy * p1t.z;
+  p2t.x += Sx * p2t.z;
+  p2t.y += Sy * p2t.z;
+  Float e0 = p1t.x * p2t.y - p1t.y * p2t.x;
+  Float e1 = p2t.x * p0t.y - p2t.y * p0t.x;
+  Float e2 = p0t.x * p1t.y - p0t.y * p1t.x;
+  if ((e0 < 0 || e1 < 0 || e2 < 0) && (e0 > 0 || e1 > 0 || e2 > 0))
+    return false;
+  Float det = e0 + e1 + e2;
+  if (det == 0) return false;
+  p0t.z *= Sz;
+  p1t.z *= Sz;
+  p2t.z *= Sz;
+  Float tScaled = e0 * p0t.z + e1 * p1t.z + e2 * p2t.z;
+  if (det < 0 && (tScaled >= 0 || tScaled < ray.tmax * det))
+    return false;
+  else if (det > 0 && (tScaled <= 0 || tScaled > ray.tmax * det))
+    return false;
+  // Compute barycentric coordinates and $t$ value for triangle intersection
+  Float invDet = 1 / det;
+  Float t = tScaled * invDet;
+
+  // Ensure that computed triangle $t$ is conservatively greater than zero
+
+  // Compute $\delta_z$ term for triangle $t$ error bounds
+  Float maxZt = MaxComp(Abs(Vector3f(p0t.z, p1t.z, p2t.z)));
+  Float deltaZ = Gamma(3) * maxZt;
+
+  // Compute $\delta_x$ and $\delta_y$ terms for triangle $t$ error bounds
+  Float maxXt = MaxComp(Abs(Vector3f(p0t.x, p1t.x, p2t.x)));
+  Float maxYt = MaxComp(Abs(Vector3f(p0t.y, p1t.y, p2t.y)));
+  Float deltaX = Gamma(5) * (maxXt + maxZt);
+  Float deltaY = Gamma(5) * (maxYt + maxZt);
+
+  // Compute $\delta_e$ term for triangle $t$ error bounds
+  Float deltaE =
+      2 * (Gamma(2) * maxXt * maxYt + deltaY * maxXt + deltaX * maxYt);
+
+  // Compute $\delta_t$ term for triangle $t$ error bounds and check _t_
+  Float maxE = MaxComp(Abs(Vector3f(e0, e1, e2)));
+  Float deltaT = 3 *
+      (Gamma(3) * maxE * maxZt + deltaE * maxZt + deltaZ * maxE) *
+      std::abs(invDet);
+  if (t <= deltaT) return false;
+  b[0] = e0 * invDet;
+  b[1] = e1 * invDet;
+  b[2] = e2 * invDet;
+  *t_hit = t;
+  return true;
+}
+
 class Triangle : public Shape {
-  std::shared_ptr<TriangleMesh> mesh;
+  std::shared_ptr<const TriangleMesh> mesh;
   const int *v;
   int face_index;
   void GetUVs(Point2 uv[3]) const {
@@ -62,7 +135,7 @@ class Triangle : public Shape {
   }
  public:
   Triangle(const Transform &ObjectToWorld, const Transform &WorldToObject,
-      const std::shared_ptr<TriangleMesh> &mesh, int triNumber)
+      const std::shared_ptr<const TriangleMesh> &mesh, int triNumber)
       : Shape(ObjectToWorld, WorldToObject), mesh(mesh) {
     v = &mesh->vertex_indices[3 * triNumber];
     face_index = mesh->face_indices.size() ? mesh->face_indices[triNumber] : 0;
@@ -81,79 +154,47 @@ class Triangle : public Shape {
     return Union(Bounds3f(world2object.ToPoint(p0), world2object.ToPoint(p1)), world2object.ToPoint(p2));
   }
 
+  const Point3f &Vertex(int i) const { return mesh->p[v[i]]; }
+
+  // A zero geometric normal, FillIntersection rejects every hit on such a triangle
+  bool Degenerate() const {
+    return Cross(Vertex(2) - Vertex(0), Vertex(1) - Vertex(0)).LengthSquared() == 0;
+  }
+
   bool Intersect(const Ray &ray, SurfaceIntersection &isect) const override {
+    Float t, b[3];
+    if (!WatertightIntersect(Vertex(0), Vertex(1), Vertex(2), ray, &t, b)) return false;
+    return FillIntersection(ray, t, b, isect);
+  }
+
+  // Completes a hit found by WatertightIntersect, lets aggregates run the test inline and fill the
+  // intersection only for the closest triangle
+  bool FillIntersection(const Ray &ray, Float t, const Float b[3], SurfaceIntersection &isect) const {
     const Point3f &p0 = mesh->p[v[0]];
     const Point3f &p1 = mesh->p[v[1]];
     const Point3f &p2 = mesh->p[v[2]];
-    Point3f p0t = p0 - Vector3f(ray.o);
-    Point3f p1t = p1 - Vector3f(ray.o);
-    Point3f p2t = p2 - Vector3f(ray.o);
-    auto rayd = Abs(ray.d);
-    int kz = rayd.x > rayd.y ? (rayd.x > rayd.z ? 0 : 2) : (rayd.y > rayd.z ? 1 : 2);
-    int kx = kz + 1;
-    if (kx == 3) kx = 0;
-    int ky = kx + 1;
-    if (ky == 3) ky = 0;
-    Vector3f d = Permute(ray.d, Vector3i(kx, ky, kz));
-    p0t = Permute(p0t, Vector3i(kx, ky, kz));
-    p1t = Permute(p1t, Vector3i(kx, ky, kz));
-    p2t = Permute(p2t, Vector3i(kx, ky, kz));
-    Float Sx = -d.x / d.z;
-    Float Sy = -d.y / d.z;
-    Float Sz = 1.f / d.z;
-    p0t.x += Sx * p0t.z;
-    p0t.y += Sy * p0t.z;
-    p1t.x += Sx * p1t.z;
-    p1t.y += Sy * p1t.z;
-    p2t.x += Sx * p2t.z;
-    p2t.y += Sy * p2t.z;
-    Float e0 = p1t.x * p2t.y - p1t.y * p2t.x;
-    Float e1 = p2t.x * p0t.y - p2t.y * p0t.x;
-    Float e2 = p0t.x * p1t.y - p0t.y * p1t.x;
-    if ((e0 < 0 || e1 < 0 || e2 < 0) && (e0 > 0 || e1 > 0 || e2 > 0))
-      return false;
-    Float det = e0 + e1 + e2;
-    if (det == 0) return false;
-    p0t.z *= Sz;
-    p1t.z *= Sz;
-    p2t.z *= Sz;
-    Float tScaled = e0 * p0t.z + e1 * p1t.z + e2 * p2t.z;
-    if (det < 0 && (tScaled >= 0 || tScaled < ray.tmax * det))
-      return false;
-    else if (det > 0 && (tScaled <= 0 || tScaled > ray.tmax * det))
-      return false;
-    Float invDet = 1 / det;
-    Float b0 = e0 * invDet;
-    Float b1 = e1 * invDet;
-    Float b2 = e2 * invDet;
-    Float t = tScaled * invDet;
-
-    // Ensure that computed triangle $t$ is conservatively greater than zero
-
-    // Compute $\delta_z$ term for triangle $t$ error bounds
-    Float maxZt = MaxComp(Abs(Vector3f(p0t.z, p1t.z, p2t.z)));
-    Float deltaZ = Gamma(3) * maxZt;
-
-    // Compute $\delta_x$ and $\delta_y$ terms for triangle $t$ error bounds
-    Float maxXt = MaxComp(Abs(Vector3f(p0t.x, p1t.x, p2t.x)));
-    Float maxYt = MaxComp(Abs(Vector3f(p0t.y, p1t.y, p2t.y)));
-    Float deltaX = Gamma(5) * (maxXt + maxZt);
-    Float deltaY = Gamma(5) * (maxYt + maxZt);
-
-    // Compute $\delta_e$ term for triangle $t$ error bounds
-    Float deltaE =
-        2 * (Gamma(2) * maxXt * maxYt + deltaY * maxXt + deltaX * maxYt);
-
-    // Compute $\delta_t$ term for triangle $t$ error bounds and check _t_
-    Float maxE = MaxComp(Abs(Vector3f(e0, e1, e2)));
-    Float deltaT = 3 *
-        (Gamma(3) * maxE * maxZt + deltaE * maxZt + deltaZ * maxE) *
-        std::abs(invDet);
-    if (t <= deltaT) return false;
+    Float b0 = b[0], b1 = b[1], b2 = b[2];
 
     Point2f uv[3];
     GetUVs(uv);
 
+    // Compute triangle partial derivatives
+    Vector2f duv02 = uv[0] - uv[2], duv12 = uv[1] - uv[2];
+    Vector3f dp02 = p0 - p2, dp12 = p1 - p2;
+    Float determinant = duv02[0] * duv12[1] - duv02[1] * duv12[0];
+    bool degenerate_uv = std::abs(determinant) < 1e-8f;
+    Float invdet = degenerate_uv ? 0 : 1 / determinant;
+    Vector3f dpdu, dpdv;
+    if (!degenerate_uv) {
+      dpdu = (duv12[1] * dp02 - duv02[1] * dp12) * invdet;
+      dpdv = (-duv12[0] * dp02 + duv02[0] * dp12) * invdet;
+    }
+    if (degenerate_uv || Cross(dpdu, dpdv).LengthSquared() == 0) {
+      Vector3f ng = Cross(p2 - p0, p1 - p0);
+      if (ng.LengthSquared() == 0) return false;
+      Frame::ComputeCoordinateSystem(Normalize(ng), dpdu, dpdv);
+    }
+
     // Compute error bounds for triangle intersection
     Float xAbsSum =
         (std::abs(b0 * p0.x) + std::abs(b1 * p1.x) + std::abs(b2 * p2.x));
@@ -172,6 +213,9 @@ class Triangle : public Shape {
     isect.time = ray.time;
     isect.shape = this;
     isect.face_index = face_index;
+    isect.dpdu = dpdu;
+    isect.dpdv = dpdv;
+    isect.dndu = isect.dndv = Normal3f(0);
     ShadingPoint sp;
     sp.texcoords = uvHit;
     isect.sp = sp;
@@ -185,6 +229,12 @@ class Triangle : public Shape {
         isect.shading_frame = isect.geo_frame;
       }
       isect.geo_frame = Frame(Faceforward(isect.geo_frame.n, isect.shading_frame.n));
+      if (!degenerate_uv) {
+        Normal3f dn1 = mesh->n[v[0]] - mesh->n[v[2]];
+        Normal3f dn2 = mesh->n[v[1]] - mesh->n[v[2]];
+        isect.dndu = (duv12[1] * dn1 - duv02[1] * dn2) * invdet;
+        isect.dndv = (-duv12[0] * dn1 + duv02[0] * dn2) * invdet;
+      }
     } else {
       isect.shading_frame = isect.geo_frame;
     }
@@ -192,84 +242,25 @@ class Triangle : public Shape {
   }
 
   bool IntersectP(const Ray &ray) const override {
+    Float t, b[3];
+    return WatertightIntersect(Vertex(0), Vertex(1), Vertex(2), ray, &t, b);
+  }
+  Float Area() const override {
     const Point3f &p0 = mesh->p[v[0]];
     const Point3f &p1 = mesh->p[v[1]];
     const Point3f &p2 = mesh->p[v[2]];
-    Point3f p0t = p0 - Vector3f(ray.o);
-    Point3f p1t = p1 - Vector3f(ray.o);
-    Point3f p2t = p2 - Vector3f(ray.o);
-    auto rayd = Abs(ray.d);
-    int kz = rayd.x > rayd.y ? (rayd.x > rayd.z ? 0 : 2) : (rayd.y > rayd.z ? 1 : 2);
-    int kx = kz + 1;
-    if (kx == 3) kx = 0;
-    int ky = kx + 1;
-    if (ky == 3) ky = 0;
-    Vector3f d = Permute(ray.d, Vector3i(kx, ky, kz));
-    p0t = Permute(p0t, Vector3i(kx, ky, kz));
-    p1t = Permute(p1t, Vector3i(kx, ky, kz));
-    p2t = Permute(p2t, Vector3i(kx, ky, kz));
-    Float Sx = -d.x / d.z;
-    Float Sy = -d.y / d.z;
-    Float Sz = 1.f / d.z;
-    p0t.x += Sx * p0t.z;
-    p0t.y += Sy * p0t.z;
-    p1t.x += Sx * p1t.z;
-    p1t.y += Sy * p1t.z;
-    p2t.x += Sx * p2t.z;
-    p2t.y += Sy * p2t.z;
-    Float e0 = p1t.x * p2t.y - p1t.y * p2t.x;
-    Float e1 = p2t.x * p0t.y - p2t.y * p0t.x;
-    Float e2 = p0t.x * p1t.y - p0t.y * p1t.x;
-    if ((e0 < 0 || e1 < 0 || e2 < 0) && (e0 > 0 || e1 > 0 || e2 > 0))
-      return false;
-    Float det = e0 + e1 + e2;
-    if (det == 0) return false;
-    p0t.z *= Sz;
-    p1t.z *= Sz;
-    p2t.z *= Sz;
-    Float tScaled = e0 * p0t.z + e1 * p1t.z + e2 * p2t.z;
-    if (det < 0 && (tScaled >= 0 || tScaled < ray.tmax * det))
-      return false;
-    else if (det > 0 && (tScaled <= 0 || tScaled > ray.tmax * det))
-      return false;
-    // Compute barycentric coordinates and $t$ value for triangle intersection
-    Float invDet = 1 / det;
-    Float b0 = e0 * invDet;
-    Float b1 = e1 * invDet;
-    Float b2 = e2 * invDet;
-    Float t = tScaled * invDet;
-
-    // Ensure that computed triangle $t$ is conservatively greater than zero
-
-    // Compute $\delta_z$ term for triangle $t$ error bounds
-    Float maxZt = MaxComp(Abs(Vector3f(p0t.z, p1t.z, p2t.z)));
-    Float deltaZ = Gamma(3) * maxZt;
-
-    // Compute $\delta_x$ and $\delta_y$ terms for triangle $t$ error bounds
-    Float maxXt = MaxComp(Abs(Vector3f(p0t.x, p1t.x, p2t.x)));
-    Float maxYt = MaxComp(Abs(Vector3f(p0t.y, p1t.y, p2t.y)));
-    Float deltaX = Gamma(5) * (maxXt + maxZt);
-    Float deltaY = Gamma(5) * (maxYt + maxZt);
-
-    // Compute $\delta_e$ term for triangle $t$ error bounds
-    Float deltaE =
-        2 * (Gamma(2) * maxXt * maxYt + deltaY * maxXt + deltaX * maxYt);
-
-    // Compute $\delta_t$ term for triangle $t$ error bounds and check _t_
-    Float maxE = MaxComp(Abs(Vector3f(e0, e1, e2)));
-    Float deltaT = 3 *
-        (Gamma(3) * maxE * maxZt + deltaE * maxZt + deltaZ * maxE) *
-        std::abs(invDet);
-    if (t <= deltaT) return false;
-    return true;
+    return 0.5 * Cross(p1 - p0, p2 - p0).Length();
   }
-  Float Area() const override {
+  DirectionCone NormalBounds() const override {
     const Point3f &p0 = mesh->p[v[0]];
     const Point3f &p1 = mesh->p[v[1]];
     const Point3f &p2 = mesh->p[v[2]];
-    return 0.5 * Cross(p1 - p0, p2 - p0).Length();
+    Normal3f n = Normalize(Cross(p0 - p2, p1 - p2));
+    // Match the orientation Intersect gives the geometric normal
+    if (mesh->n) n = Faceforward(n, mesh->n[v[0]] + mesh->n[v[1]] + mesh->n[v[2]]);
+    return DirectionCone(n);
   }
-  void Sample(const Point2f &u, SurfaceSample &sample) const override {
+  void SamplePosition(const Point2f &u, SurfaceSample &sample) const override {
     const Point3f &p0 = mesh->p[v[0]];
     const Point3f &p1 = mesh->p[v[1]];
     const Point3f &p2 = mesh->p[v[2]];
@@ -277,9 +268,13 @@ class Triangle : public Shape {
     sample.p = b[0] * p0 + b[1] * p1 + (1 - b[0] - b[1]) * p2;
     sample.normal = Normalize(Cross(p1 - p0, p2 - p0));
     if (mesh->n) {
+      // Orient like the geometric normal reported by Intersect
       Normal3f ns (b[0] * mesh->n[v[0]] + b[1] * mesh->n[v[1]] + (1 - b[0] - b[1]) * mesh->n[v[2]]);
-      sample.normal = Dot(sample.normal, ns) < 0.0f ? sample.normal : sample.normal;
+      sample.normal = Faceforward(sample.normal, ns);
     }
+  }
+  void Sample(const Point2f &u, SurfaceSample &sample) const override {
+    SamplePosition(u, sample);
     sample.pdf = 1 / Area();
     Vector3 wi = sample.p - sample.ref;
     if (wi.LengthSquared() == 0) sample.pdf = 0;
@@ -291,19 +286,26 @@ class Triangle : public Shape {
   }
 };
 
-std::vector<std::shared_ptr<Shape>> CreateTriangleMesh(
+// Triangles referencing a possibly shared mesh, each gets its own material and light
+inline std::vector<std::shared_ptr<Shape>> CreateTriangles(
+    const Transform &object2world, const Transform &world2object,
+    const std::shared_ptr<const TriangleMesh> &mesh) {
+  std::vector<std::shared_ptr<Shape>> tris;
+  tris.reserve(mesh->triangles_num);
+  for (int i = 0; i < mesh->triangles_num; ++i)
+    tris.push_back(std::make_shared<Triangle>(object2world, world2object,
+                                              mesh, i));
+  return tris;
+}
+
+inline std::vector<std::shared_ptr<Shape>> CreateTriangleMesh(
     const Transform &object2world, const Transform &world2object,
     int nTriangles, const int *vertexIndices, int nVertices, const Point3f *p,
     const Vector3f *s, const Normal3f *n, const Point2f *uv,
     const int *faceIndices = nullptr) {
   std::shared_ptr<TriangleMesh> mesh = std::make_shared<TriangleMesh>(
       object2world, nTriangles, vertexIndices, nVertices, p, s, n, uv, faceIndices);
-  std::vector<std::shared_ptr<Shape>> tris;
-  tris.reserve(nTriangles);
-  for (int i = 0; i < nTriangles; ++i)
-    tris.push_back(std::make_shared<Triangle>(object2world, world2object,
-                                              mesh, i));
-  return tris;
+  return CreateTriangles(object2world, world2object, mesh);
 }
 
 }
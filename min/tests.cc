@@ -1,5 +1,14 @@
 #include <min/math/linalg.h>
+#include <min/math/fastmath.h>
+#include <min/visual/rng.h>
+#include <min/visual/distribution.h>
+#include <min/visual/camera.h>
+#include <min/visual/sampling.h>
+#include <min/visual/lowdiscrepancy.h>
+#include <min/visual/bluenoise.h>
 #include <gtest/gtest.h>
+#include <chrono>
+#include <limits>
 
 using namespace min;
 
@@ -37,6 +46,429 @@ TEST(MatrixTest, Trivial) {
   std::cout << Transpose(m41).ToString() << std::endl;
   std::cout << Inverse(m41).ToString() << std::endl;
 }
+
+// The scalar instantiations are the reference for the SSE/AVX ones. Single operations round the same,
+// sums of products only to about an ulp of their terms since the compiler may contract either side
+// into FMAs, e.g. with -mfma, -march=native or clang's default
+using ScalarVector3f = VectorND<3, float32, kNone>;
+using ScalarVector4f = VectorND<4, float32, kNone>;
+using ScalarMatrix4f = MatrixND<4, float32, kNone>;
+
+template <int dim, InstSetExt ISE>
+void ExpectSameVector(const VectorND<dim, float32, ISE> &simd, const VectorND<dim, float32, kNone> &scalar) {
+  for (int i = 0; i < dim; i++) EXPECT_EQ(simd[i], scalar[i]);
+}
+
+// Within ulps rounding steps of magnitude, the sum of absolute terms that produced the values
+void ExpectNearUlps(float32 simd, float32 scalar, float32 magnitude, float32 ulps = 2) {
+  EXPECT_NEAR(simd, scalar, ulps * std::numeric_limits<float32>::epsilon() * magnitude);
+}
+
+TEST(VectorTest, SimdMatchesScalar) {
+  Rng rng(7);
+  auto uniform = [&]() { return 8 * rng.UniformFloat() - 4; };
+  for (int n = 0; n < 1000; n++) {
+    Vector3f a(uniform(), uniform(), uniform()), b(uniform(), uniform(), uniform());
+    ScalarVector3f sa(a.x, a.y, a.z), sb(b.x, b.y, b.z);
+    ExpectSameVector(a + b, sa + sb);
+    ExpectSameVector(a - b, sa - sb);
+    ExpectSameVector(a * b, sa * sb);
+    ExpectSameVector(a / b, sa / sb);
+    ExpectSameVector(2.5f * a, 2.5f * sa);
+    ExpectSameVector(-a, -sa);
+    Vector3f cross = Cross(a, b);
+    ScalarVector3f scalar_cross = Cross(sa, sb), abs_a = Abs(sa), abs_b = Abs(sb);
+    ExpectNearUlps(cross.x, scalar_cross.x, abs_a.y * abs_b.z + abs_a.z * abs_b.y);
+    ExpectNearUlps(cross.y, scalar_cross.y, abs_a.z * abs_b.x + abs_a.x * abs_b.z);
+    ExpectNearUlps(cross.z, scalar_cross.z, abs_a.x * abs_b.y + abs_a.y * abs_b.x);
+    ExpectSameVector(Abs(a), Abs(sa));
+    ExpectSameVector(Sqrt(Abs(a)), Sqrt(Abs(sa)));
+    ExpectSameVector(Min(a, b), ScalarVector3f(std::min(sa.x, sb.x), std::min(sa.y, sb.y), std::min(sa.z, sb.z)));
+    ExpectSameVector(Max(a, b), ScalarVector3f(std::max(sa.x, sb.x), std::max(sa.y, sb.y), std::max(sa.z, sb.z)));
+    ExpectNearUlps(Dot(a, b), Dot(sa, sb), Dot(abs_a, abs_b));
+    ExpectNearUlps(a.LengthSquared(), sa.LengthSquared(), sa.LengthSquared());
+
+    Vector4f c(a.x, a.y, a.z, uniform()), d(b.x, b.y, b.z, uniform());
+    ScalarVector4f sc(c.x, c.y, c.z, c.w), sd(d.x, d.y, d.z, d.w);
+    ExpectSameVector(c + d, sc + sd);
+    ExpectSameVector(c * d, sc * sd);
+    ExpectSameVector(c / d, sc / sd);
+    ExpectNearUlps(Dot(c, d), Dot(sc, sd), Dot(Abs(sc), Abs(sd)));
+  }
+}
+
+TEST(MatrixTest, SimdMatchesScalar) {
+  Rng rng(11);
+  auto uniform = [&]() { return 8 * rng.UniformFloat() - 4; };
+  for (int n = 0; n < 1000; n++) {
+    Matrix4f a, b;
+    ScalarMatrix4f sa, sb;
+    for (int i = 0; i < 4; i++) {
+      for (int j = 0; j < 4; j++) {
+        sa[i][j] = a[i][j] = uniform();
+        sb[i][j] = b[i][j] = uniform();
+      }
+    }
+    Matrix4f product = a * b;
+    ScalarMatrix4f scalar_product = sa * sb;
+    for (int i = 0; i < 4; i++) {
+      for (int j = 0; j < 4; j++) {
+        float magnitude = 0;
+        for (int k = 0; k < 4; k++) magnitude += std::abs(sa[i][k] * sb[k][j]);
+        ExpectNearUlps(product[i][j], scalar_product[i][j], magnitude);
+      }
+    }
+
+    // The SIMD inverse takes a different elimination order, compare the residuals instead
+    Matrix4f inv = Inverse(a);
+    ScalarMatrix4f scalar_inv = Inverse(sa);
+    Matrix4f identity = a * inv;
+    for (int i = 0; i < 4; i++) {
+      for (int j = 0; j < 4; j++) {
+        float scale = std::max(1.f, std::abs(scalar_inv[i][j]));
+        EXPECT_NEAR(inv[i][j], scalar_inv[i][j], 1e-3f * scale);
+        EXPECT_NEAR(identity[i][j], i == j ? 1.f : 0.f, 1e-3f);
+      }
+    }
+  }
+}
+
+TEST(RngTest, AdvanceRoundTrip) {
+  Rng rng(42, 7);
+  uint32_t first[16];
+  for (uint32_t &v : first) v = rng.UniformUInt32();
+  rng.Advance(1000);
+  rng.Advance(-1000 - 16);
+  for (uint32_t v : first) EXPECT_EQ(rng.UniformUInt32(), v);
+  Rng skipped(42, 7), stepped(42, 7);
+  skipped.Advance(12345);
+  for (int i = 0; i < 12345; ++i) stepped.UniformUInt32();
+  EXPECT_EQ(skipped.UniformUInt32(), stepped.UniformUInt32());
+}
+
+TEST(RngTest, Rng8LanesMatchScalar) {
+  Rng8 rng8(42, 3);
+  rng8.Advance(5);
+  Rng lanes[Rng8::kLanes];
+  for (int i = 0; i < Rng8::kLanes; ++i) {
+    lanes[i] = Rng(42, 3 * Rng8::kLanes + i);
+    lanes[i].Advance(5);
+  }
+  uint32_t out[Rng8::kLanes];
+  for (int n = 0; n < 100; ++n) {
+    rng8.UniformUInt32(out);
+    for (int i = 0; i < Rng8::kLanes; ++i) EXPECT_EQ(out[i], lanes[i].UniformUInt32());
+  }
+}
+
+TEST(AliasTableTest, PmfSumsToOne) {
+  Float w[] = {0.5f, 3, 0, 1, 7.25f, 0.01f, 2};
+  AliasTable table(w, 7);
+  double sum = 0;
+  for (int i = 0; i < table.Count(); ++i) sum += table.Pmf(i);
+  EXPECT_NEAR(sum, 1.0, 1e-6);
+  EXPECT_EQ(table.Pmf(2), 0);
+  AliasTable uniform(std::vector<Float>(5, 0).data(), 5);
+  for (int i = 0; i < uniform.Count(); ++i) EXPECT_FLOAT_EQ(uniform.Pmf(i), 0.2f);
+}
+
+TEST(AliasTableTest, FrequenciesMatchPmf) {
+  Float w[] = {0.5f, 3, 0, 1, 7.25f, 0.01f, 2};
+  AliasTable table(w, 7);
+  const int n = 1 << 20;
+  std::vector<int> count(table.Count());
+  Rng rng;
+  for (int i = 0; i < n; ++i) {
+    Float pmf;
+    int index = table.Sample(rng.UniformFloat(), &pmf);
+    EXPECT_EQ(pmf, table.Pmf(index));
+    count[index]++;
+  }
+  EXPECT_EQ(count[2], 0);
+  for (int i = 0; i < table.Count(); ++i) {
+    // Five binomial standard deviations
+    double p = table.Pmf(i);
+    EXPECT_NEAR(double(count[i]) / n, p, 5 * std::sqrt(p * (1 - p) / n) + 1e-9);
+  }
+}
+
+TEST(CameraTest, PinholeDirectionsMatchScalar) {
+  // An odd count so both the vector lanes and the scalar tail are covered
+  constexpr int n = 37;
+  Vector3f d(-0.8f, 0.45f, 1.f), step_x(0.0025f, 0.f, -0.0003f), step_y(0.0001f, -0.0025f, 0.0002f);
+  Rng rng(7);
+  CameraSample samples[n];
+  for (CameraSample &cs : samples) {
+    cs.pfilm = Point2f(640 * rng.UniformFloat(), 360 * rng.UniformFloat());
+    cs.time = rng.UniformFloat();
+  }
+  alignas(16) Float x[n], y[n], z[n], time[n];
+  Float *const dir[3] = {x, y, z};
+  PinholeDirections(samples, n, d, step_x, step_y, dir, time);
+  for (int i = 0; i < n; ++i) {
+    ScalarVector3f sd(d.x, d.y, d.z), sx(step_x.x, step_x.y, step_x.z), sy(step_y.x, step_y.y, step_y.z);
+    ScalarVector3f v = sd + samples[i].pfilm.x * sx + samples[i].pfilm.y * sy, expected = Normalize(v);
+    // Either side may fuse the multiply-adds, so allow rounding of the summed terms and of the normalize
+    ScalarVector3f terms = Abs(sd) + std::abs(samples[i].pfilm.x) * Abs(sx) + std::abs(samples[i].pfilm.y) * Abs(sy);
+    Float *lanes[3] = {x, y, z};
+    for (int c = 0; c < 3; ++c)
+      ExpectNearUlps(lanes[c][i], expected[c], 1 + terms[c] / v.Length());
+    EXPECT_EQ(time[i], samples[i].time);
+  }
+}
+
+TEST(SamplingTest, EqualAreaRoundTrip) {
+  for (int j = 0; j <= 256; ++j) {
+    for (int i = 0; i <= 256; ++i) {
+      Point2f p(i / 256.f, j / 256.f);
+      Vector3f d = EqualAreaSquareToSphere(p);
+      EXPECT_NEAR(d.Length(), 1.f, 1e-5f);
+      Point2f q = EqualAreaSphereToSquare(d);
+      // The octahedron edges where |u| + |v| = 1 meet the square border, where directions are shared
+      bool border = i == 0 || i == 256 || j == 0 || j == 256;
+      if (!border) {
+        EXPECT_NEAR(q.x, p.x, 4e-6f);
+        EXPECT_NEAR(q.y, p.y, 4e-6f);
+      }
+      Vector3f e = EqualAreaSquareToSphere(q);
+      EXPECT_NEAR(Dot(d, e), 1.f, 1e-5f);
+    }
+  }
+}
+
+TEST(SamplingTest, EqualAreaIsUniform) {
+  // Uniform directions fall into every cell of the square with the same probability
+  constexpr int res = 16, n = 1 << 20;
+  std::vector<int> count(res * res, 0);
+  Rng rng(3);
+  for (int i = 0; i < n; ++i) {
+    Point2f u(rng.UniformFloat(), rng.UniformFloat());
+    Point2f p = EqualAreaSphereToSquare(UniformSampleSphere(u));
+    int x = std::min(int(p.x * res), res - 1), y = std::min(int(p.y * res), res - 1);
+    count[y * res + x]++;
+  }
+  double expected = double(n) / (res * res);
+  for (int c : count) EXPECT_NEAR(c, expected, 5 * std::sqrt(expected));
+}
+
+TEST(SamplingTest, OctahedralEdgesMirror) {
+  // The octahedral wrap mode continues a lookup across an edge of the square at the mirrored other
+  // coordinate, which is only continuous if both sides of the edge map to the same direction
+  for (int i = 0; i <= 64; ++i) {
+    Float t = i / 64.f;
+    EXPECT_NEAR(Dot(EqualAreaSquareToSphere(Point2f(0, t)), EqualAreaSquareToSphere(Point2f(0, 1 - t))), 1, 1e-5f);
+    EXPECT_NEAR(Dot(EqualAreaSquareToSphere(Point2f(1, t)), EqualAreaSquareToSphere(Point2f(1, 1 - t))), 1, 1e-5f);
+    EXPECT_NEAR(Dot(EqualAreaSquareToSphere(Point2f(t, 0)), EqualAreaSquareToSphere(Point2f(1 - t, 0))), 1, 1e-5f);
+    EXPECT_NEAR(Dot(EqualAreaSquareToSphere(Point2f(t, 1)), EqualAreaSquareToSphere(Point2f(1 - t, 1))), 1, 1e-5f);
+  }
+}
+
+// Number of elementary intervals of the 2^m points that do not hold exactly one point
+int ElementaryIntervalViolations(const std::vector<Point2f> &points) {
+  int m = Log2Int(int(points.size())), violations = 0;
+  for (int k = 0; k <= m; ++k) {
+    // Intervals 2^k wide and 2^(m - k) high
+    int nx = 1 << k, ny = 1 << (m - k);
+    std::vector<int> count(size_t(nx) * ny, 0);
+    for (const Point2f &p : points) count[std::min(int(p.y * ny), ny - 1) * nx + std::min(int(p.x * nx), nx - 1)]++;
+    for (int c : count) violations += c != 1;
+  }
+  return violations;
+}
+
+template <typename RandomizerX, typename RandomizerY>
+std::vector<Point2f> SobolPoints(int n, RandomizerX x, RandomizerY y) {
+  std::vector<Point2f> points(n);
+  for (int i = 0; i < n; ++i) points[i] = Point2f(SobolSample(i, 0, x), SobolSample(i, 1, y));
+  return points;
+}
+
+TEST(LowDiscrepancyTest, SobolIsZeroTwoNet) {
+  EXPECT_EQ(ElementaryIntervalViolations(SobolPoints(256, NoRandomizer(), NoRandomizer())), 0);
+  for (uint32_t seed = 0; seed < 8; ++seed) {
+    uint32_t sx = uint32_t(MixBits(2 * seed)), sy = uint32_t(MixBits(2 * seed + 1));
+    EXPECT_EQ(ElementaryIntervalViolations(SobolPoints(256, OwenScrambler(sx), OwenScrambler(sy))), 0);
+    EXPECT_EQ(ElementaryIntervalViolations(SobolPoints(256, FastOwenScrambler(sx), FastOwenScrambler(sy))), 0);
+  }
+}
+
+TEST(LowDiscrepancyTest, ShiftedOwenSobolPrefixesAreStratified) {
+  // PMJ02 patterns are Owen scrambled Sobol points under a per pixel and dimension digital shift
+  for (int pixel = 0; pixel < 5; ++pixel) {
+    for (int dim = 0; dim < 4; ++dim) {
+      uint64_t hash = Hash(uint64_t(pixel), dim);
+      OwenScrambler ox(uint32_t(MixBits(2 * dim))), oy(uint32_t(MixBits(2 * dim + 1)));
+      uint32_t shift_x = uint32_t(hash), shift_y = uint32_t(hash >> 32U);
+      auto x = [&](uint32_t v) { return ox(v) ^ shift_x; };
+      auto y = [&](uint32_t v) { return oy(v) ^ shift_y; };
+      for (int n = 1; n <= 256; n *= 2) EXPECT_EQ(ElementaryIntervalViolations(SobolPoints(n, x, y)), 0) << n;
+    }
+  }
+}
+
+TEST(BlueNoiseTest, DigitalShiftKeepsStrata) {
+  for (int pixel = 0; pixel < 50; ++pixel) {
+    Point2i p(pixel % 8, pixel / 8);
+    for (int dim = 0; dim < 6; dim += 2) {
+      uint32_t bx = BlueNoiseBits(dim, p), by = BlueNoiseBits(dim + 1, p);
+      OwenScrambler ox(uint32_t(MixBits(dim))), oy(uint32_t(MixBits(dim + 1)));
+      auto x = [&](uint32_t v) { return ox(v) ^ bx; };
+      auto y = [&](uint32_t v) { return oy(v) ^ by; };
+      EXPECT_EQ(ElementaryIntervalViolations(SobolPoints(16, x, y)), 0);
+    }
+  }
+}
+
+TEST(BlueNoiseTest, DimensionsAreIndependent) {
+  // Consecutive dimensions must not be shifted copies of one texture, so no toroidal offset between
+  // them may correlate like one would
+  constexpr int res = 64;
+  std::vector<double> a(res * res), b(res * res);
+  for (int y = 0; y < res; ++y) {
+    for (int x = 0; x < res; ++x) {
+      a[y * res + x] = BlueNoise(0, Point2i(x, y)) - 0.5;
+      b[y * res + x] = BlueNoise(1, Point2i(x, y)) - 0.5;
+    }
+  }
+  double norm = 0;
+  for (int i = 0; i < res * res; ++i) norm += a[i] * a[i];
+  double max_correlation = 0;
+  for (int oy = 0; oy < res; ++oy) {
+    for (int ox = 0; ox < res; ++ox) {
+      double sum = 0;
+      for (int y = 0; y < res; ++y)
+        for (int x = 0; x < res; ++x) sum += a[y * res + x] * b[Mod(y + oy, res) * res + Mod(x + ox, res)];
+      max_correlation = std::max(max_correlation, std::abs(sum) / norm);
+    }
+  }
+  EXPECT_LT(max_correlation, 0.15);
+}
+
+TEST(BlueNoiseTest, LowFrequenciesAreSuppressed) {
+  // Share of the spectral power below radius 8, white noise would hold the share of the frequencies there
+  constexpr int res = 64, radius = 8;
+  std::vector<double> texture(res * res);
+  for (int y = 0; y < res; ++y)
+    for (int x = 0; x < res; ++x) texture[y * res + x] = BlueNoise(2, Point2i(x, y));
+  double low = 0, total = 0;
+  int low_frequencies = 0;
+  for (int v = -res / 2; v < res / 2; ++v) {
+    for (int u = -res / 2; u < res / 2; ++u) {
+      if (u == 0 && v == 0) continue;
+      double re = 0, im = 0;
+      for (int y = 0; y < res; ++y) {
+        for (int x = 0; x < res; ++x) {
+          double phase = -2 * kPi * double(u * x + v * y) / res;
+          re += texture[y * res + x] * std::cos(phase);
+          im += texture[y * res + x] * std::sin(phase);
+        }
+      }
+      double power = re * re + im * im;
+      total += power;
+      if (u * u + v * v < radius * radius) low += power, low_frequencies++;
+    }
+  }
+  EXPECT_LT(low / total, 0.1 * low_frequencies / (res * res - 1.0));
+}
+
+// Largest absolute error of fast against a double precision reference over n steps of [lo, hi]
+template <typename F, typename R>
+double MaxAbsError(float lo, float hi, F fast, R reference, int n = 1 << 20) {
+  double ret = 0;
+  for (int i = 0; i <= n; ++i) {
+    float x = lo + (hi - lo) * float(i) / float(n);
+    ret = std::max(ret, std::abs(double(fast(x)) - reference(double(x))));
+  }
+  return ret;
+}
+
+template <typename F, typename R>
+double MaxRelError(float lo, float hi, F fast, R reference, int n = 1 << 20) {
+  double ret = 0;
+  for (int i = 0; i <= n; ++i) {
+    float x = lo + (hi - lo) * float(i) / float(n);
+    double r = reference(double(x));
+    ret = std::max(ret, std::abs(double(fast(x)) - r) / std::abs(r));
+  }
+  return ret;
+}
+
+TEST(FastMathTest, Accuracy) {
+  EXPECT_LT(MaxAbsError(-8192, 8192, [](float x) { return FastSin(x); }, [](double x) { return std::sin(x); }), 1e-7);
+  EXPECT_LT(MaxAbsError(-8192, 8192, [](float x) { return FastCos(x); }, [](double x) { return std::cos(x); }), 1e-7);
+  EXPECT_LT(MaxAbsError(-1, 1, [](float x) { return FastACos(x); }, [](double x) { return std::acos(x); }), 3e-7);
+  // 1 ulp is a relative error of up to 2^-23
+  EXPECT_LT(MaxRelError(-87.3f, 88, [](float x) { return FastExp(x); }, [](double x) { return std::exp(x); }), 2.4e-7);
+  EXPECT_LT(MaxRelError(1e-6f, 1e6f, [](float x) { return FastLog(x); }, [](double x) { return std::log(x); }), 2.4e-7);
+  for (float y : {-3.f, -0.7f, 0.f, 0.7f, 3.f}) {
+    EXPECT_LT(MaxRelError(-50, 50, [=](float x) { return FastAtan2(y == 0 ? 1.f : y, x); },
+                          [=](double x) { return std::atan2(y == 0 ? 1.0 : double(y), x); }), 3.6e-7);
+    EXPECT_LT(MaxRelError(-50, 50, [=](float x) { return FastAtan2(x, y); },
+                          [=](double x) { return std::atan2(x, double(y)); }, (1 << 20) + 1), 3.6e-7);
+  }
+  EXPECT_EQ(FastAtan2(0.f, 0.f), 0.f);
+  EXPECT_EQ(FastAtan2(0.f, -1.f), float(kPi));
+  EXPECT_EQ(FastAtan2(-0.f, -1.f), -float(kPi));
+  EXPECT_EQ(FastLog(0.f), -std::numeric_limits<float>::infinity());
+  EXPECT_TRUE(std::isnan(FastLog(-1.f)));
+}
+
+TEST(FastMathTest, LanesMatchScalar) {
+  for (int i = 0; i < 4096; ++i) {
+    Vector4f x([=](int k) { return float(4 * i + k) * 0.0371f - 300.f; });
+    Vector4f y([=](int k) { return float(7 * i + k) * -0.0113f + 50.f; });
+    Vector4f s, c;
+    FastSinCos(x, &s, &c);
+    Vector4f a = FastAtan2(y, x), ac = FastACos(x * Vector4f(1.f / 300)), e = FastExp(x * Vector4f(0.25f));
+    Vector4f l = FastLog(Abs(x));
+    for (int k = 0; k < 4; ++k) {
+      EXPECT_EQ(s[k], FastSin(x[k]));
+      EXPECT_EQ(c[k], FastCos(x[k]));
+      EXPECT_EQ(a[k], FastAtan2(y[k], x[k]));
+      EXPECT_EQ(ac[k], FastACos(x[k] * (1.f / 300)));
+      EXPECT_EQ(e[k], FastExp(x[k] * 0.25f));
+      EXPECT_EQ(l[k], FastLog(std::abs(x[k])));
+    }
+  }
+}
+
+// Throughput against libm, printed only; run with --gtest_also_run_disabled_tests
+TEST(FastMathTest, DISABLED_Benchmark) {
+  const int n = 1 << 20;
+  std::vector<float> in(n), out(n);
+  for (int i = 0; i < n; ++i) in[i] = float((i * 7919) % n) / n * 6 - 3;
+  auto time = [&](const char *name, auto f) {
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < n; ++i) out[i] = f(in[i]);
+    auto end = std::chrono::steady_clock::now();
+    std::cout << name << ": " << std::chrono::duration<double, std::nano>(end - start).count() / n << " ns" << std::endl;
+  };
+  auto time4 = [&](const char *name, auto f) {
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < n; i += 4) {
+      Vector4f r = f(Vector4f(in[i], in[i + 1], in[i + 2], in[i + 3]));
+      for (int k = 0; k < 4; ++k) out[i + k] = r[k];
+    }
+    auto end = std::chrono::steady_clock::now();
+    std::cout << name << ": " << std::chrono::duration<double, std::nano>(end - start).count() / n << " ns" << std::endl;
+  };
+  time("std::sin", [](float x) { return std::sin(x); });
+  time("FastSin", [](float x) { return FastSin(x); });
+  time4("FastSinCos x4", [](const Vector4f &x) { Vector4f s, c; FastSinCos(x, &s, &c); return s; });
+  time("std::atan2", [](float x) { return std::atan2(x, 0.5f); });
+  time("FastAtan2", [](float x) { return FastAtan2(x, 0.5f); });
+  time4("FastAtan2 x4", [](const Vector4f &x) { return FastAtan2(x, Vector4f(0.5f)); });
+  time("std::acos", [](float x) { return std::acos(x * (1.f / 3)); });
+  time("FastACos", [](float x) { return FastACos(x * (1.f / 3)); });
+  time4("FastACos x4", [](const Vector4f &x) { return FastACos(x * Vector4f(1.f / 3)); });
+  time("std::exp", [](float x) { return std::exp(x); });
+  time("FastExp", [](float x) { return FastExp(x); });
+  time4("FastExp x4", [](const Vector4f &x) { return FastExp(x); });
+  time("std::log", [](float x) { return std::log(x + 3.001f); });
+  time("FastLog", [](float x) { return FastLog(x + 3.001f); });
+  time4("FastLog x4", [](const Vector4f &x) { return FastLog(x + Vector4f(3.001f)); });
+}
+
 using namespace min;
 int main() {
   testing::InitGoogleTest();
@@ -1,53 +1,47 @@
 #include <min/visual/texture.h>
 #include <min/visual/image.h>
 #include <min/visual/mipmap.h>
+#include <min/visual/resource_cache.h>
 
 namespace min {
 
 class ImageTexture : public Texture {
-  std::unique_ptr<MIPMap> mipmap = nullptr;
-  int width, height;
+  std::shared_ptr<const MIPMap> mipmap = nullptr;
+  // Applied at lookup so texels keep the range of the source image
+  Float scale = 1;
  public:
   void initialize(const Json &json) override {
     auto filename = GetFileResolver()->Resolve(json["filename"].get<std::string>());
     auto wrap = Value<std::string>(json, "warp_mode", "repeat");
-    auto scale = Value(json, "scale", 1.f);
+    scale = Value(json, "scale", 1.f);
     auto wm = ImageWrapMode::kRepeat;
     if (wrap == "black") wm = ImageWrapMode::kBlack;
     if (wrap == "clamp") wm = ImageWrapMode::kClamp;
     auto gamma = Value(json, "gamma", HasExtension(filename.string(), "png"));
 
-    // Create MIPMap
-    Point2i resolution;
-    std::unique_ptr<Vector3[]> texels = ReadImage(filename.string(), resolution.x, resolution.y);
-    if (!texels) {
+    // Texels are read lazily through the global cache
+    if (!fs::exists(filename)) {
       MIN_WARN("Creating a constant grey texture to replace \"{}\".", filename.string());
-      resolution.x = resolution.y = 1;
-      texels.reset(new Vector3(0.5));
-    }
-    // Flip image in y;
-    for (int y = 0; y < resolution.y / 2; y++) {
-      for (int x = 0; x < resolution.x; x++) {
-        int o1 = y * resolution.x + x;
-        int o2 = (resolution.y - 1 - y) * resolution.x + x;
-        std::swap(texels[o1], texels[o2]);
-      }
-    }
-    if (texels) {
-      std::unique_ptr<Vector3[]> converted_texels(new Vector3[resolution.x * resolution.y]);
-      for (int i = 0; i < resolution.x * resolution.y; i++) {
-        for (int j = 0; j < 3; j++) {
-          converted_texels[i][j] = scale * (gamma ? InverseGammaCorrect(texels[i][j]) : texels[i][j]);
-        }
-      }
-      mipmap.reset(new MIPMap(resolution, converted_texels.get(), wm));
-    } else {
-      Vector3 val(scale);
-      mipmap.reset(new MIPMap(Point2i(1, 1), &val));
+      Vector3 val(0.5f);
+      mipmap = std::make_shared<MIPMap>(Point2i(1, 1), &val);
+      return;
     }
+    TextureCache::ImageOptions options;
+    options.wrap_mode = wm;
+    options.gamma = gamma;
+    options.flip_y = true;
+    mipmap = ResourceCache<MIPMap>::Get().GetOrCreate(
+        ResourceKey(filename, int(wm), options.gamma, options.flip_y, options.fallback),
+        [&] { return std::make_shared<MIPMap>(TextureCache::Get().AddTexture(filename.string(), options)); });
   }
   Spectrum Evaluate(const ShadingPoint &sp) const override {
-    return mipmap->Lookup(sp.texcoords);
+    // Isotropic trilinear filter covering the larger axis of the pixel footprint
+    Float width = 2 * std::max(std::max(std::abs(sp.dudx), std::abs(sp.dudy)),
+                               std::max(std::abs(sp.dvdx), std::abs(sp.dvdy)));
+    return mipmap->Lookup(sp.texcoords, width) * scale;
+  }
+  Spectrum Average() const override {
+    return mipmap->Lookup(Point2f(0.5f, 0.5f), 1) * scale;
   }
 };
 MIN_IMPLEMENTATION(Texture, ImageTexture, "image");
@@ -0,0 +1,102 @@
+#include "bluenoise.h"
+#include "rng.h"
+#include <mutex>
+
+namespace min {
+
+static constexpr int kBlueNoiseRes = 64;
+static constexpr int kBlueNoiseTextures = 16;
+
+// Ulichney's void-and-cluster method on a torus, returns the rank of every texel
+static std::vector<uint16_t> VoidAndCluster(uint64_t seed) {
+  const int n = kBlueNoiseRes * kBlueNoiseRes;
+  const Float sigma = 1.5f;
+  std::vector<Float> kernel(n);
+  for (int y = 0; y < kBlueNoiseRes; ++y) {
+    for (int x = 0; x < kBlueNoiseRes; ++x) {
+      int dx = std::min(x, kBlueNoiseRes - x), dy = std::min(y, kBlueNoiseRes - y);
+      kernel[y * kBlueNoiseRes + x] = std::exp(-(dx * dx + dy * dy) / (2 * sigma * sigma));
+    }
+  }
+  std::vector<uint8_t> pattern(n, 0);
+  std::vector<Float> energy(n, 0);
+  auto toggle = [&](int i, bool set) {
+    pattern[i] = set;
+    int ix = i % kBlueNoiseRes, iy = i / kBlueNoiseRes;
+    for (int y = 0; y < kBlueNoiseRes; ++y) {
+      const Float *row = &kernel[Mod(y - iy, kBlueNoiseRes) * kBlueNoiseRes];
+      for (int x = 0; x < kBlueNoiseRes; ++x)
+        energy[y * kBlueNoiseRes + x] += set ? row[Mod(x - ix, kBlueNoiseRes)] : -row[Mod(x - ix, kBlueNoiseRes)];
+    }
+  };
+  // Tightest cluster among set texels, largest void among empty ones
+  auto extreme = [&](bool set) {
+    int best = -1;
+    for (int i = 0; i < n; ++i) {
+      if (pattern[i] != set) continue;
+      if (best < 0 || (set ? energy[i] > energy[best] : energy[i] < energy[best])) best = i;
+    }
+    return best;
+  };
+
+  // Initial binary pattern, relaxed until removing the tightest cluster refills the largest void
+  Rng rng(seed);
+  int ones = n / 10;
+  for (int placed = 0; placed < ones;) {
+    int i = int(rng.UniformUInt32() % n);
+    if (!pattern[i]) {
+      toggle(i, true);
+      ++placed;
+    }
+  }
+  for (int iteration = 0; iteration < n; ++iteration) {
+    int cluster = extreme(true);
+    toggle(cluster, false);
+    int hole = extreme(false);
+    toggle(hole, true);
+    if (hole == cluster) break;
+  }
+  std::vector<uint8_t> initial = pattern;
+  std::vector<Float> initial_energy = energy;
+
+  std::vector<uint16_t> ranks(n);
+  // Ranks below the initial pattern, by removing clusters
+  for (int rank = ones - 1; rank >= 0; --rank) {
+    int cluster = extreme(true);
+    toggle(cluster, false);
+    ranks[cluster] = uint16_t(rank);
+  }
+  // Ranks above, by filling voids until the texture is full
+  pattern = initial;
+  energy = initial_energy;
+  for (int rank = ones; rank < n; ++rank) {
+    int hole = extreme(false);
+    toggle(hole, true);
+    ranks[hole] = uint16_t(rank);
+  }
+  return ranks;
+}
+
+// Rank of the texel of p in the texture of a dimension, textures are generated on first use
+static int BlueNoiseRank(int dimension, const Point2i &p) {
+  static std::once_flag generated[kBlueNoiseTextures];
+  static std::vector<uint16_t> ranks[kBlueNoiseTextures];
+  int texture = Mod(dimension, kBlueNoiseTextures);
+  std::call_once(generated[texture], [&]() { ranks[texture] = VoidAndCluster(MixBits(uint64_t(texture) + 7)); });
+  // Dimensions sharing a texture read it at different offsets
+  uint64_t offset = MixBits(uint64_t(dimension / kBlueNoiseTextures) + 1);
+  int x = Mod(p.x + int(offset % kBlueNoiseRes), kBlueNoiseRes);
+  int y = Mod(p.y + int((offset >> 32U) % kBlueNoiseRes), kBlueNoiseRes);
+  return ranks[texture][y * kBlueNoiseRes + x];
+}
+
+Float BlueNoise(int dimension, const Point2i &p) {
+  return (BlueNoiseRank(dimension, p) + 0.5f) / Float(kBlueNoiseRes * kBlueNoiseRes);
+}
+
+uint32_t BlueNoiseBits(int dimension, const Point2i &p) {
+  // 4096 ranks fill the top 12 bits, the half step centers the value in its stratum
+  return (uint32_t(BlueNoiseRank(dimension, p)) << 20U) | (1U << 19U);
+}
+
+}
@@ -0,0 +1,16 @@
+#pragma once
+
+#include "defs.h"
+
+namespace min {
+
+// Tiled 64x64 void-and-cluster blue noise in [0, 1). Each of 16 consecutive dimensions reads its own
+// independently generated texture, so e.g. the two halves of a 2D sample are uncorrelated while
+// neighbouring pixels stay anti-correlated. Dimensions further apart share textures at different offsets.
+Float BlueNoise(int dimension, const Point2i &p);
+
+// The same noise as 32 bit fixed point, XORed onto a sample it is a digital shift, which keeps the
+// elementary interval stratification of (0, 2) points and permutes the strata between pixels
+uint32_t BlueNoiseBits(int dimension, const Point2i &p);
+
+}
@@ -0,0 +1,283 @@
+#pragma once
+
+#include "defs.h"
+#include "spectrum.h"
+#include "frame.h"
+#include "sampling.h"
+#include "fresnel.h"
+#include "microfacet.h"
+
+namespace min {
+
+struct BxDFFlags {
+  enum Type {
+    kNone = 0,
+    kDiffuse = 1ULL,
+    kGlossy = 1ULL << 1U,
+    kReflection = 1ULL << 2U,
+    kTransmission = 1ULL << 3U,
+    kSpecular = 1ULL << 4U,
+    kAll = kDiffuse | kGlossy | kTransmission | kSpecular | kReflection,
+    kAllButSpecular = kAll & ~kSpecular
+  };
+};
+
+struct BSDFSample {
+  Vector3f wi;
+  Float pdf;
+  Spectrum f;
+  BxDFFlags::Type sampled_type = BxDFFlags::kNone;
+};
+
+inline bool Refract(const Vector3 &wi, const Normal3 &n, Float eta,
+                    Vector3f *wt) {
+  // Compute $\cos \theta_\roman{t}$ using Snell's law
+  Float cosThetaI = Dot(n, wi);
+  Float sin2ThetaI = std::max(Float(0), Float(1 - cosThetaI * cosThetaI));
+  Float sin2ThetaT = eta * eta * sin2ThetaI;
+
+  // Handle total internal reflection for transmission
+  if (sin2ThetaT >= 1) return false;
+  Float cosThetaT = std::sqrt(1 - sin2ThetaT);
+  *wt = eta * -wi + (eta * cosThetaI - cosThetaT) * Vector3f(n);
+  return true;
+}
+
+// Lobes are plain classes without virtual functions, BxDF below dispatches over the closed set
+
+class DiffuseBRDF : public BxDFFlags {
+  Spectrum R;
+ public:
+  static constexpr Type kType = Type(kReflection | kDiffuse);
+  explicit DiffuseBRDF(const Spectrum &R) : R(R) {}
+  Spectrum Evaluate(const Vector3f &wo, const Vector3f &wi) const {
+    return R * kInvPi;
+  }
+  void Sample(const Point2f &u, const Vector3f &wo, BSDFSample &sample) const {
+    sample.wi = CosineSampleHemisphere(u);
+    if (wo.z < 0) sample.wi.z *= -1;
+    sample.pdf = Pdf(wo, sample.wi);
+    sample.f = Evaluate(wo, sample.wi);
+  }
+  Float Pdf(const Vector3 &wo, const Vector3 &wi) const {
+    return wo.z * wi.z > 0 ? std::abs(Frame::CosTheta(wi)) * kInvPi : 0;
+  }
+};
+
+class MirrorBRDF : public BxDFFlags {
+  Spectrum R;
+ public:
+  static constexpr Type kType = Type(kReflection | kSpecular);
+  explicit MirrorBRDF(const Spectrum &R) : R(R) {}
+  Spectrum Evaluate(const Vector3f &wo, const Vector3f &wi) const {
+    return Spectrum(0);
+  }
+  void Sample(const Point2f &u, const Vector3f &wo, BSDFSample &sample) const {
+    sample.wi = Vector3f(-wo.x, -wo.y, wo.z);
+    sample.pdf = 1;
+    sample.f = R / std::abs(sample.wi.z);
+  }
+  Float Pdf(const Vector3 &wo, const Vector3 &wi) const {
+    return 0;
+  }
+};
+
+class SpecularBRDF : public BxDFFlags {
+  Spectrum R;
+  Float etaI, etaT;
+ public:
+  static constexpr Type kType = Type(kReflection | kSpecular);
+  SpecularBRDF(const Spectrum &R, Float etaI, Float etaT) : R(R), etaI(etaI), etaT(etaT) {}
+  Spectrum Evaluate(const Vector3f &wo, const Vector3f &wi) const {
+    return Spectrum(0);
+  }
+  void Sample(const Point2f &u, const Vector3f &wo, BSDFSample &sample) const {
+    sample.wi = Vector3f(-wo.x, -wo.y, wo.z);
+    sample.pdf = 1;
+    sample.f = FrDielectric(Frame::CosTheta(sample.wi), etaI, etaT) * R / std::abs(sample.wi.z);
+  }
+  Float Pdf(const Vector3 &wo, const Vector3 &wi) const {
+    return 0;
+  }
+};
+
+class SpecularBTDF : public BxDFFlags {
+  Spectrum T;
+  Float etaA, etaB;
+ public:
+  static constexpr Type kType = Type(kTransmission | kSpecular);
+  SpecularBTDF(const Spectrum &T, Float etaA, Float etaB) : T(T), etaA(etaA), etaB(etaB) {}
+  Spectrum Evaluate(const Vector3f &wo, const Vector3f &wi) const {
+    return Spectrum(0.f);
+  }
+  void Sample(const Point2f &u, const Vector3f &wo, BSDFSample &sample) const {
+    bool entering = Frame::CosTheta(wo) > 0;
+    Float etaI = entering ? etaA : etaB;
+    Float etaT = entering ? etaB : etaA;
+    if (!Refract(wo, Faceforward(Normal3f(0, 0, 1), wo), etaI / etaT, &sample.wi)) {
+      sample.f = Spectrum(0);
+      return;
+    }
+    sample.pdf = 1;
+    Spectrum ft = T * (1 - FrDielectric(Frame::CosTheta(sample.wi), etaA, etaB));
+    ft *= (etaI * etaI) / (etaT * etaT);
+    sample.f = ft / std::abs(Frame::CosTheta(sample.wi));
+  }
+  Float Pdf(const Vector3f &wo, const Vector3f &wi) const { return 0; }
+};
+
+class GGXBRDF : public BxDFFlags {
+  Spectrum R;
+  MicrofacetDistribution distrib;
+  Float eta;
+ public:
+  static constexpr Type kType = Type(kReflection | kGlossy);
+  GGXBRDF(const Spectrum &R, const MicrofacetDistribution &distribution, Float eta)
+      : R(R), distrib(distribution), eta(eta) {}
+  Spectrum Evaluate(const Vector3f &wo, const Vector3f &wi) const {
+    Float costhetaO = std::abs(Frame::CosTheta(wo)), costhetaI = std::abs(Frame::CosTheta(wi));
+    Normal3 wh = wi + wo;
+    if (costhetaI == 0.f || costhetaO == 0.f) return Spectrum(0);
+    if (wh.x == 0.f && wh.y == 0.f && wh.z == 0.f) return Spectrum(0);
+    wh = Normalize(wh);
+    return R * distrib.Evaluate(wh) * distrib.SmithG(wo, wi, wh) *
+        FrDielectric(Dot(wi, Faceforward(wh, Vector3(0, 0, 1))), 1, eta) /
+        (4 * costhetaI * costhetaO);
+  }
+  void Sample(const Point2f &u, const Vector3f &wo, BSDFSample &sample) const {
+    if (wo.z == 0) {
+      sample.f = Spectrum(0);
+      return;
+    }
+    Vector3 wh = distrib.Sample(u, wo);
+    if (Dot(wo, wh) < 0) {
+      sample.f = Spectrum(0);
+      return;
+    }
+    sample.wi = -wo + 2 * Dot(wo, wh) * wh;
+    if (!(wo.z * sample.wi.z > 0.f)) {
+      sample.f = Spectrum(0);
+      return;
+    }
+    sample.pdf = distrib.Pdf(wo, wh) / (4 * Dot(wo, wh));
+    sample.f = Evaluate(wo, sample.wi);
+  }
+  Float Pdf(const Vector3 &wo, const Vector3 &wi) const {
+    if (!(wo.z * wi.z > 0)) return 0;
+    Vector3 wh = Normalize(wo + wi);
+    return distrib.Pdf(wo, wh) / (4 * Dot(wo, wh));
+  }
+};
+
+class GGXBTDF : public BxDFFlags {
+  Spectrum T;
+  Float etaA, etaB;
+  MicrofacetDistribution distrib;
+ public:
+  static constexpr Type kType = Type(kTransmission | kGlossy);
+  GGXBTDF(const Spectrum &T, const MicrofacetDistribution &distribution, Float etaA, Float etaB)
+      : T(T), etaA(etaA), etaB(etaB), distrib(distribution) {}
+  Spectrum Evaluate(const Vector3f &wo, const Vector3f &wi) const {
+    if (wo.z * wi.z > 0) return Spectrum(0);
+    Float costhetaO = Frame::CosTheta(wo), costhetaI = Frame::CosTheta(wi);
+    if (costhetaI == 0. || costhetaO == 0.) return Spectrum(0);
+    Float eta = costhetaO > 0 ? (etaB / etaA) : (etaA / etaB);
+    Vector3 wh = Normalize(wo + wi * eta);
+    if (wh.z < 0) wh *= -1;
+    Float F = FrDielectric(Dot(wo, wh), etaA, etaB);
+    Float factor = 1 / eta;
+    Float s = Dot(wo, wh) + eta * Dot(wi, wh);
+    return T * (1 - F) * std::abs(distrib.Evaluate(wh) * distrib.SmithG(wo, wi, wh)
+     * eta * eta * AbsDot(wi, wh) * AbsDot(wo, wh) * factor * factor /
+        (costhetaI * costhetaO * s * s));
+  }
+  void Sample(const Point2f &u, const Vector3f &wo, BSDFSample &sample) const {
+    if (wo.z == 0) {
+      sample.f = Spectrum(0);
+      return;
+    }
+    Vector3 wh = distrib.Sample(u, wo);
+    if (Dot(wo, wh) < 0) {
+      sample.f = Spectrum(0);
+      return;
+    }
+    Float eta = Frame::CosTheta(wo) > 0 ? (etaB / etaA) : (etaA / etaB);
+    if (!Refract(wo, wh, eta, &sample.wi)) {
+      sample.f = Spectrum(0);
+      return;
+    }
+    sample.pdf = Pdf(wo, sample.wi);
+    sample.f = Evaluate(wo, sample.wi);
+  }
+  Float Pdf(const Vector3 &wo, const Vector3 &wi) const {
+    if (wo.z * wi.z > 0) return 0;
+    Float eta = Frame::CosTheta(wo) > 0 ? (etaB / etaA) : (etaA / etaB);
+    Vector3 wh = Normalize(wo + wi * eta);
+    Float s = Dot(wo, wh) + eta * Dot(wi, wh);
+    return distrib.Pdf(wo, wh) * std::abs((eta * eta * Dot(wi, wh)) / (s * s));
+  }
+};
+
+// Tagged union over the lobe types, stored inline in BSDF
+class BxDF : public BxDFFlags {
+ public:
+  enum Kind {
+    kDiffuseBRDF,
+    kMirrorBRDF,
+    kSpecularBRDF,
+    kSpecularBTDF,
+    kGGXBRDF,
+    kGGXBTDF
+  };
+
+  BxDF() {}
+#define MIN_BXDF_LOBE(Lobe, member) \
+  BxDF(const Lobe &b) : type(Lobe::kType), kind(k##Lobe), member(b) {}
+  MIN_BXDF_LOBE(DiffuseBRDF, diffuse)
+  MIN_BXDF_LOBE(MirrorBRDF, mirror)
+  MIN_BXDF_LOBE(SpecularBRDF, specular_brdf)
+  MIN_BXDF_LOBE(SpecularBTDF, specular_btdf)
+  MIN_BXDF_LOBE(GGXBRDF, ggx_brdf)
+  MIN_BXDF_LOBE(GGXBTDF, ggx_btdf)
+#undef MIN_BXDF_LOBE
+  BxDF(const BxDF &) = delete;
+  BxDF &operator=(const BxDF &) = delete;
+
+  bool MatchesFlags(Type t) const { return (type & t) == type; }
+
+  template <typename F>
+  MIN_FORCE_INLINE auto Dispatch(F &&func) const {
+    switch (kind) {
+      case kDiffuseBRDF: return func(diffuse);
+      case kMirrorBRDF: return func(mirror);
+      case kSpecularBRDF: return func(specular_brdf);
+      case kSpecularBTDF: return func(specular_btdf);
+      case kGGXBRDF: return func(ggx_brdf);
+      default: return func(ggx_btdf);
+    }
+  }
+
+  Spectrum Evaluate(const Vector3f &wo, const Vector3f &wi) const {
+    return Dispatch([&](const auto &b) { return b.Evaluate(wo, wi); });
+  }
+  void Sample(const Point2f &u, const Vector3f &wo, BSDFSample &sample) const {
+    Dispatch([&](const auto &b) { b.Sample(u, wo, sample); });
+  }
+  Float Pdf(const Vector3 &wo, const Vector3 &wi) const {
+    return Dispatch([&](const auto &b) { return b.Pdf(wo, wi); });
+  }
+
+  Type type = kNone;
+ private:
+  Kind kind = kDiffuseBRDF;
+  union {
+    DiffuseBRDF diffuse;
+    MirrorBRDF mirror;
+    SpecularBRDF specular_brdf;
+    SpecularBTDF specular_btdf;
+    GGXBRDF ggx_brdf;
+    GGXBTDF ggx_btdf;
+  };
+};
+
+}
@@ -6,14 +6,119 @@
 #include "geometry.h"
 #include "transform.h"
 #include "film.h"
+#include <min/common/memory.h>
 
 namespace min {
 
+struct CameraSample {
+  Point2f pfilm, plens;
+  Float time = 0;
+};
+
+// Camera rays in structure of arrays form for batch consumers, ray i is lane i of every array. Arrays
+// are 64 byte aligned and padded to whole groups of kLanes so vector code needs no tail
+struct CameraRays {
+  static constexpr int kLanes = 16;
+  int count = 0, capacity = 0;
+  Float *ox = nullptr, *oy = nullptr, *oz = nullptr;
+  Float *dx = nullptr, *dy = nullptr, *dz = nullptr;
+  Float *time = nullptr, *weight = nullptr;
+
+  CameraRays() = default;
+  explicit CameraRays(int n) { Resize(n); }
+  CameraRays(const CameraRays &) = delete;
+  CameraRays &operator=(const CameraRays &) = delete;
+  ~CameraRays() { FreeAligned(ox); }
+
+  // Keeps the storage when it is large enough
+  void Resize(int n) {
+    count = n;
+    if (n <= capacity) return;
+    FreeAligned(ox);
+    capacity = (n + kLanes - 1) / kLanes * kLanes;
+    Float *arrays[8];
+    arrays[0] = AllocAligned<Float>(8 * size_t(capacity));
+    for (int i = 1; i < 8; ++i) arrays[i] = arrays[0] + size_t(i) * capacity;
+    ox = arrays[0], oy = arrays[1], oz = arrays[2];
+    dx = arrays[3], dy = arrays[4], dz = arrays[5];
+    time = arrays[6], weight = arrays[7];
+  }
+
+  void Set(int i, const Ray &ray, Float w) {
+    ox[i] = ray.o.x, oy[i] = ray.o.y, oz[i] = ray.o.z;
+    dx[i] = ray.d.x, dy[i] = ray.d.y, dz[i] = ray.d.z;
+    time[i] = ray.time, weight[i] = w;
+  }
+
+  Ray Get(int i) const {
+    return Ray(Point3f(ox[i], oy[i], oz[i]), Vector3f(dx[i], dy[i], dz[i]), kInfinity, time[i]);
+  }
+};
+
+// Directions Normalize(d + pfilm.x * step_x + pfilm.y * step_y) of a pinhole camera and the sample
+// times, written to 16 byte aligned arrays dir[0..2] and time. Four rays per SSE iteration with the
+// operations in the order of the scalar path, so lanes match it up to FMA contraction
+inline void PinholeDirections(const CameraSample *samples, int n, const Vector3f &d, const Vector3f &step_x,
+                              const Vector3f &step_y, Float *const dir[3], Float *time) {
+  int i = 0;
+#if defined(MIN_SIMD_SSE) && !defined(MIN_USE_DOUBLE)
+  const __m128 one = _mm_set1_ps(1.f);
+  __m128 base[3], sx[3], sy[3];
+  for (int c = 0; c < 3; ++c) {
+    base[c] = _mm_set1_ps(d[c]);
+    sx[c] = _mm_set1_ps(step_x[c]);
+    sy[c] = _mm_set1_ps(step_y[c]);
+  }
+  for (; i + 4 <= n; i += 4) {
+    const CameraSample *cs = samples + i;
+    __m128 x = _mm_setr_ps(cs[0].pfilm.x, cs[1].pfilm.x, cs[2].pfilm.x, cs[3].pfilm.x);
+    __m128 y = _mm_setr_ps(cs[0].pfilm.y, cs[1].pfilm.y, cs[2].pfilm.y, cs[3].pfilm.y);
+    __m128 v[3];
+    for (int c = 0; c < 3; ++c)
+      v[c] = _mm_add_ps(_mm_add_ps(base[c], _mm_mul_ps(x, sx[c])), _mm_mul_ps(y, sy[c]));
+    __m128 length_squared = _mm_add_ps(_mm_add_ps(_mm_mul_ps(v[0], v[0]), _mm_mul_ps(v[1], v[1])),
+                                       _mm_mul_ps(v[2], v[2]));
+    __m128 inv_length = _mm_div_ps(one, _mm_sqrt_ps(length_squared));
+    for (int c = 0; c < 3; ++c) _mm_store_ps(dir[c] + i, _mm_mul_ps(inv_length, v[c]));
+    _mm_store_ps(time + i, _mm_setr_ps(cs[0].time, cs[1].time, cs[2].time, cs[3].time));
+  }
+#endif
+  for (; i < n; ++i) {
+    Vector3f v = Normalize(d + samples[i].pfilm.x * step_x + samples[i].pfilm.y * step_y);
+    for (int c = 0; c < 3; ++c) dir[c][i] = v[c];
+    time[i] = samples[i].time;
+  }
+}
+
 class Camera : public Unit {
  protected:
   Transform camera2world;
  public:
   virtual Float GenerateRay(const Point2f &pfilm, const Point2f &plens, Float time, Ray &ray) const = 0;
+  // Default traces two more camera rays one pixel away in x and y
+  virtual Float GenerateRayDifferential(const Point2f &pfilm, const Point2f &plens, Float time,
+                                        RayDifferential &ray) const {
+    Float weight = GenerateRay(pfilm, plens, time, ray);
+    if (weight == 0) return 0;
+    Ray rx, ry;
+    if (GenerateRay(pfilm + Vector2f(1, 0), plens, time, rx) == 0) return weight;
+    if (GenerateRay(pfilm + Vector2f(0, 1), plens, time, ry) == 0) return weight;
+    ray.rx_origin = rx.o;
+    ray.rx_direction = rx.d;
+    ray.ry_origin = ry.o;
+    ray.ry_direction = ry.d;
+    ray.has_differentials = true;
+    return weight;
+  }
+  // Fills rays with one ray per sample, e.g. a whole tile at once. The default generates them one by one
+  virtual void GenerateRays(const CameraSample *samples, int n, CameraRays &rays) const {
+    rays.Resize(n);
+    for (int i = 0; i < n; ++i) {
+      Ray ray;
+      Float weight = GenerateRay(samples[i].pfilm, samples[i].plens, samples[i].time, ray);
+      rays.Set(i, ray, weight);
+    }
+  }
   std::shared_ptr<Film> film;
 };
 MIN_INTERFACE(Camera)
@@ -54,6 +54,121 @@ struct Distribution1D {
   }
 };
 
+// Walker/Vose alias method, O(1) discrete sampling
+class AliasTable {
+ public:
+  struct Bin {
+    Float q, p;
+    int alias;
+  };
+
+  AliasTable() = default;
+  AliasTable(const Float *w, int n) : bins(n) { Build(w, n, bins.data()); }
+
+  int Count() const { return (int)bins.size(); }
+
+  // u_remapped receives a fresh uniform sample that can be reused for further dimensions
+  int Sample(Float u, Float *pmf = nullptr, Float *u_remapped = nullptr) const {
+    return Sample(bins.data(), Count(), u, pmf, u_remapped);
+  }
+
+  // Piecewise constant density over [0, 1) with one segment per weight
+  Float SampleContinuous(Float u, Float *pdf) const {
+    Float du;
+    int offset = Sample(u, pdf, &du);
+    if (pdf) *pdf *= Count();
+    return (offset + du) / Count();
+  }
+
+  Float Pmf(int index) const { return bins[index].p; }
+
+  // Fills n bins from n weights, a zero sum gives the uniform distribution
+  static void Build(const Float *w, int n, Bin *bins) {
+    double sum = 0;
+    for (int i = 0; i < n; ++i) sum += w[i];
+    for (int i = 0; i < n; ++i) bins[i].p = sum > 0 ? Float(w[i] / sum) : Float(1) / n;
+
+    // Pair each under-full bin with an over-full one, the leftovers are full up to rounding
+    struct Outcome {
+      double p_hat;
+      int index;
+    };
+    std::vector<Outcome> under, over;
+    for (int i = 0; i < n; ++i) {
+      double p_hat = double(bins[i].p) * n;
+      if (p_hat < 1) under.push_back({p_hat, i});
+      else over.push_back({p_hat, i});
+    }
+    while (!under.empty() && !over.empty()) {
+      Outcome un = under.back(), ov = over.back();
+      under.pop_back();
+      over.pop_back();
+      bins[un.index].q = Float(un.p_hat);
+      bins[un.index].alias = ov.index;
+      double p_excess = un.p_hat + ov.p_hat - 1;
+      if (p_excess < 1) under.push_back({p_excess, ov.index});
+      else over.push_back({p_excess, ov.index});
+    }
+    for (const Outcome &o : over) bins[o.index] = {1, bins[o.index].p, -1};
+    for (const Outcome &o : under) bins[o.index] = {1, bins[o.index].p, -1};
+  }
+
+  static int Sample(const Bin *bins, int n, Float u, Float *pmf, Float *u_remapped) {
+    int offset = std::min<int>(int(u * n), n - 1);
+    Float up = std::min<Float>(u * n - offset, kOneMinusEpsilon);
+    const Bin &bin = bins[offset];
+    if (up < bin.q) {
+      if (pmf) *pmf = bin.p;
+      if (u_remapped) *u_remapped = std::min<Float>(up / bin.q, kOneMinusEpsilon);
+      return offset;
+    }
+    if (pmf) *pmf = bins[bin.alias].p;
+    if (u_remapped) *u_remapped = std::min<Float>((up - bin.q) / (1 - bin.q), kOneMinusEpsilon);
+    return bin.alias;
+  }
+
+ private:
+  std::vector<Bin> bins;
+};
+
+// Distribution2D sampled in O(1) with alias tables. The rows and the marginal share one allocation,
+// the marginal follows the nv rows of nu bins. The warp is not continuous, prefer Distribution2D
+// where stratification of u must carry over to the sampled point.
+class AliasDistribution2D {
+ public:
+  AliasDistribution2D() = default;
+  AliasDistribution2D(const Float *func, int nu, int nv) : nu(nu), nv(nv), bins(size_t(nu) * nv + nv) {
+    std::vector<Float> marginal(nv);
+    for (int v = 0; v < nv; ++v) {
+      AliasTable::Build(&func[v * nu], nu, &bins[size_t(v) * nu]);
+      double row = 0;
+      for (int u = 0; u < nu; ++u) row += func[v * nu + u];
+      marginal[v] = Float(row);
+    }
+    AliasTable::Build(marginal.data(), nv, Marginal());
+  }
+
+  Point2f SampleContinuous(const Point2f &u, Float *pdf) const {
+    Float pmfs[2], du, dv;
+    int v = AliasTable::Sample(Marginal(), nv, u[1], &pmfs[1], &dv);
+    int iu = AliasTable::Sample(&bins[size_t(v) * nu], nu, u[0], &pmfs[0], &du);
+    *pdf = pmfs[0] * pmfs[1] * nu * nv;
+    return Point2f((iu + du) / nu, (v + dv) / nv);
+  }
+  Float Pdf(const Point2f &p) const {
+    int iu = Clamp(int(p[0] * nu), 0, nu - 1);
+    int iv = Clamp(int(p[1] * nv), 0, nv - 1);
+    return bins[size_t(iv) * nu + iu].p * Marginal()[iv].p * nu * nv;
+  }
+
+ private:
+  const AliasTable::Bin *Marginal() const { return &bins[size_t(nu) * nv]; }
+  AliasTable::Bin *Marginal() { return &bins[size_t(nu) * nv]; }
+
+  int nu = 0, nv = 0;
+  std::vector<AliasTable::Bin> bins;
+};
+
 class Distribution2D {
  public:
   Distribution2D(const Float *func, int nu, int nv) {
@@ -11,14 +11,17 @@ void Film::initialize(const Json &json) {
   auto max_sample_luminanc = Value(json, "max_sample_luminance", kInfinity);
   auto filenam = GetFileResolver()->ConcateWork(Value<std::string>(json, "filename", "out.png"));
   auto filt = CreateInstanceUnique<Filter>(json["filter"]["type"], GetProps(json["filter"]));
-  Initialize(resolution, crop_window, std::move(filt), diagona, filenam.string(), scal, max_sample_luminanc);
+  auto importance_sample_filte = Value(json, "importance_sample_filter", false);
+  Initialize(resolution, crop_window, std::move(filt), diagona, filenam.string(), scal, max_sample_luminanc,
+             importance_sample_filte);
 }
 
 Bounds2i Film::GetSampleBounds() const {
+  Vector2f radius = SplatRadius();
   Bounds2f floatBounds(Floor(Point2f(cropped_pixel_bounds.pmin) +
-                           Vector2f(0.5f, 0.5f) - filter->radius),
+                           Vector2f(0.5f, 0.5f) - radius),
                        Ceil(Point2f(cropped_pixel_bounds.pmax) -
-                           Vector2f(0.5f, 0.5f) + filter->radius));
+                           Vector2f(0.5f, 0.5f) + radius));
   return (Bounds2i)floatBounds;
 }
 
@@ -32,14 +35,15 @@ Bounds2f Film::GetPhysicalExtent() const {
 std::unique_ptr<FilmTile> Film::GetFilmTile(const Bounds2i &sampleBounds) {
   // Bound image pixels that samples in _sampleBounds_ contribute to
   Vector2f halfPixel = Vector2f(0.5f, 0.5f);
+  Vector2f radius = SplatRadius();
   Bounds2f floatBounds = (Bounds2f)sampleBounds;
-  Point2i p0 = (Point2i)Ceil(floatBounds.pmin - halfPixel - filter->radius);
-  Point2i p1 = (Point2i)Floor(floatBounds.pmax - halfPixel + filter->radius) +
+  Point2i p0 = (Point2i)Ceil(floatBounds.pmin - halfPixel - radius);
+  Point2i p1 = (Point2i)Floor(floatBounds.pmax - halfPixel + radius) +
       Point2i(1, 1);
   Bounds2i tilePixelBounds = Intersect(Bounds2i(p0, p1), cropped_pixel_bounds);
   return std::unique_ptr<FilmTile>(new FilmTile(
-      tilePixelBounds, filter->radius, filter_table, filter_table_width,
-      max_sample_luminance));
+      tilePixelBounds, radius, filter_table, filter_table_width,
+      max_sample_luminance, constant_filter || importance_sample_filter));
 }
 
 void Film::Clear() {
@@ -47,20 +51,38 @@ void Film::Clear() {
     Pixel &pixel = GetPixel(p);
     pixel.value = Spectrum(0.f);
     pixel.filter_weight_sum = 0;
+    for (int c = 0; c < 3; ++c) pixel.splat[c] = 0;
   }
 }
 
 void Film::MergeFilmTile(std::unique_ptr<FilmTile> tile) {
-  std::lock_guard<std::mutex> lock(mutex);
-  for (Point2i pixel : tile->GetPixelBounds()) {
-    // Merge _pixel_ into _Film::pixels_
-    const FilmTilePixel &tilePixel = tile->GetPixel(pixel);
-    Pixel &mergePixel = GetPixel(pixel);
-    mergePixel.value += tilePixel.contrib_sum;
-    mergePixel.filter_weight_sum += tilePixel.filter_weight_sum;
+  Bounds2i bounds = tile->GetPixelBounds();
+  for (int y = bounds.pmin.y; y < bounds.pmax.y; ++y) {
+    // Only the row being merged is locked, neighbouring tiles overlap by the filter radius
+    std::lock_guard<std::mutex> lock(row_mutexes[y - cropped_pixel_bounds.pmin.y]);
+    for (int x = bounds.pmin.x; x < bounds.pmax.x; ++x) {
+      // Merge _pixel_ into _Film::pixels_
+      Point2i pixel(x, y);
+      const FilmTilePixel &tilePixel = tile->GetPixel(pixel);
+      Pixel &mergePixel = GetPixel(pixel);
+      mergePixel.value += tilePixel.contrib_sum;
+      mergePixel.filter_weight_sum += tilePixel.filter_weight_sum;
+    }
   }
 }
 
+void Film::AddSplat(const Point2f &p, Spectrum v) {
+  if (std::isnan(v.x) || std::isnan(v.y) || std::isnan(v.z)) {
+    MIN_WARN("Ignoring splatted spectrum with NaN values at ({}, {})", p.x, p.y);
+    return;
+  }
+  if (v.y > max_sample_luminance) v *= max_sample_luminance / v.y;
+  Point2i pi = Point2i(Floor(p));
+  if (!InsideExclusive(pi, cropped_pixel_bounds)) return;
+  Pixel &pixel = GetPixel(pi);
+  for (int c = 0; c < 3; ++c) pixel.splat[c].Add(v[c]);
+}
+
 void Film::SetImage(Spectrum *img) const {
   int nPixels = cropped_pixel_bounds.Area();
   for (int i = 0; i < nPixels; ++i) {
@@ -70,7 +92,7 @@ void Film::SetImage(Spectrum *img) const {
   }
 }
 
-std::vector<Spectrum> Film::GetImage(){
+std::vector<Spectrum> Film::GetImage(Float splatScale) {
   std::vector<Spectrum> ret;
   int nPixels = cropped_pixel_bounds.Area();
   for (int i = 0; i < nPixels; ++i) {
@@ -84,6 +106,10 @@ std::vector<Spectrum> Film::GetImage(){
       rgb[1] = std::max<Float>((Float)0, rgb[1] * inv_wt);
       rgb[2] = std::max<Float>((Float)0, rgb[2] * inv_wt);
     }
+    // Add splat value at pixel
+    rgb[0] += splatScale * p.splat[0];
+    rgb[1] += splatScale * p.splat[1];
+    rgb[2] += splatScale * p.splat[2];
     // Scale pixel value by _scale_
     rgb[0] *= scale;
     rgb[1] *= scale;
@@ -117,6 +143,11 @@ void Film::WriteImage(Float splatScale) {
           std::max<Float>((Float)0, rgb[3 * offset + 2] * invWt);
     }
 
+    // Add splat value at pixel
+    rgb[3 * offset] += splatScale * pixel.splat[0];
+    rgb[3 * offset + 1] += splatScale * pixel.splat[1];
+    rgb[3 * offset + 2] += splatScale * pixel.splat[2];
+
     // Scale pixel value by _scale_
     rgb[3 * offset] *= scale;
     rgb[3 * offset + 1] *= scale;
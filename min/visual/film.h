@@ -4,6 +4,8 @@
 #include "filter.h"
 #include "spectrum.h"
 #include "geometry.h"
+#include <min/common/parallel.h>
+#include <min/common/cpu.h>
 #include <mutex>
 
 namespace min {
@@ -13,16 +15,168 @@ struct FilmTilePixel {
   Float filter_weight_sum = 0.0f;
 };
 
+class FilmTile {
+  // Widest pixel footprint a filter may cover, i.e. floor(2 * radius) + 1
+  static constexpr int kMaxFilterFootprint = 32;
+  using SplatFunc = void (FilmTile::*)(const Point2f &, const Spectrum &, Float);
+
+  const Bounds2i pixel_bounds;
+  const Vector2f filter_radius, inv_filter_radius;
+  const Float *filter_table;
+  const int filter_table_size;
+  std::vector<FilmTilePixel> pixels;
+  const Float max_sample_luminance;
+  SplatFunc splat;
+  friend class Film;
+
+  // Box filter of radius 0.5, every sample belongs to exactly one pixel
+  void SplatPixel(const Point2f &pfilm, const Spectrum &l, Float sample_weight) {
+    Point2i p = (Point2i)Floor(pfilm);
+    if (!InsideExclusive(p, pixel_bounds)) return;
+    FilmTilePixel &pixel = GetPixel(p);
+    pixel.contrib_sum += l * sample_weight;
+    pixel.filter_weight_sum += 1;
+  }
+
+  template <bool kConstant, int kFootprint>
+  MIN_FORCE_INLINE void SplatFootprint(const Point2f &pfilm, const Spectrum &l, Float sample_weight) {
+    Point2f film_discrete = pfilm - Vector2f(0.5f, 0.5f);
+    Point2i p0 = (Point2i)Ceil(film_discrete - filter_radius);
+    Point2i p1 = (Point2i)Floor(film_discrete + filter_radius) + Point2i(1, 1);
+    p0 = Max(p0, pixel_bounds.pmin);
+    p1 = Min(p1, pixel_bounds.pmax);
+    if (kConstant) {
+      Spectrum contrib = l * sample_weight;
+      for (int y = p0.y; y < p1.y; ++y) {
+        for (int x = p0.x; x < p1.x; ++x) {
+          FilmTilePixel &pixel = GetPixel(Point2i(x, y));
+          pixel.contrib_sum += contrib;
+          pixel.filter_weight_sum += 1;
+        }
+      }
+      return;
+    }
+    int ifx[kFootprint], ify[kFootprint];
+    for (int x = p0.x; x < p1.x; ++x) {
+      Float fx = std::abs((x - film_discrete.x) * inv_filter_radius.x *
+          filter_table_size);
+      ifx[x - p0.x] = std::min<int>((int)fx, filter_table_size - 1);
+    }
+    for (int y = p0.y; y < p1.y; ++y) {
+      Float fy = std::abs((y - film_discrete.y) * inv_filter_radius.y *
+          filter_table_size);
+      ify[y - p0.y] = std::min<int>((int)fy, filter_table_size - 1);
+    }
+    for (int y = p0.y; y < p1.y; ++y) {
+      const Float *row = filter_table + ify[y - p0.y] * filter_table_size;
+      for (int x = p0.x; x < p1.x; ++x) {
+        // Evaluate filter value at $(x,y)$ pixel
+        Float filterWeight = row[ifx[x - p0.x]];
+
+        // Update pixel values with filtered sample contribution
+        FilmTilePixel &pixel = GetPixel(Point2i(x, y));
+        pixel.contrib_sum += l * sample_weight * filterWeight;
+        pixel.filter_weight_sum += filterWeight;
+      }
+    }
+  }
+
+  // Splatting compiled for each CpuTarget
+  template <bool kConstant, int kFootprint>
+  void SplatBaseline(const Point2f &pfilm, const Spectrum &l, Float sample_weight) {
+    SplatFootprint<kConstant, kFootprint>(pfilm, l, sample_weight);
+  }
+  template <bool kConstant, int kFootprint>
+  MIN_TARGET_AVX2 void SplatAVX2(const Point2f &pfilm, const Spectrum &l, Float sample_weight) {
+    SplatFootprint<kConstant, kFootprint>(pfilm, l, sample_weight);
+  }
+
+  template <bool kConstant, int kFootprint>
+  static SplatFunc SelectTarget() {
+    return SelectCpuVariant<SplatFunc>(&FilmTile::SplatBaseline<kConstant, kFootprint>,
+                                       &FilmTile::SplatAVX2<kConstant, kFootprint>);
+  }
+
+  template <bool kConstant>
+  static SplatFunc SelectFootprint(int footprint) {
+    if (footprint <= 2) return SelectTarget<kConstant, 2>();
+    if (footprint <= 4) return SelectTarget<kConstant, 4>();
+    if (footprint <= 8) return SelectTarget<kConstant, 8>();
+    if (footprint <= 16) return SelectTarget<kConstant, 16>();
+    return SelectTarget<kConstant, kMaxFilterFootprint>();
+  }
+ public:
+  FilmTile(const Bounds2i &pixel_bounds, const Vector2f &filter_radius,
+           const Float *filter_table, int filter_table_size,
+           Float max_sample_luminance, bool constant_filter = false)
+      : pixel_bounds(pixel_bounds),
+        filter_radius(filter_radius),
+        inv_filter_radius(1 / filter_radius.x, 1 / filter_radius.y),
+        filter_table(filter_table),
+        filter_table_size(filter_table_size),
+        max_sample_luminance(max_sample_luminance) {
+    pixels = std::vector<FilmTilePixel>(std::max<int>(0, pixel_bounds.Area()));
+    int footprint = MaxFilterFootprint(filter_radius);
+    MIN_ASSERT(footprint <= kMaxFilterFootprint);
+    if (constant_filter && filter_radius.x == 0.5f && filter_radius.y == 0.5f)
+      splat = &FilmTile::SplatPixel;
+    else if (constant_filter)
+      splat = SelectFootprint<true>(footprint);
+    else
+      splat = SelectFootprint<false>(footprint);
+  }
+
+  static int MaxFilterFootprint(const Vector2f &radius) {
+    return (int)std::floor(2 * std::max(radius.x, radius.y)) + 1;
+  }
+  static bool SupportsFilterRadius(const Vector2f &radius) {
+    return MaxFilterFootprint(radius) <= kMaxFilterFootprint;
+  }
+
+  void AddSample(const Point2f& pfilm, Spectrum l, Float sample_weight = 1.) {
+    if (l.y > max_sample_luminance) l *= max_sample_luminance / l.y;
+    (this->*splat)(pfilm, l, sample_weight);
+  }
+
+  // Filter importance sampling, the sample only contributes to the pixel it was generated for
+  void AddPixelSample(const Point2i &p, Spectrum l, Float filter_weight) {
+    if (l.y > max_sample_luminance) l *= max_sample_luminance / l.y;
+    if (!InsideExclusive(p, pixel_bounds)) return;
+    FilmTilePixel &pixel = GetPixel(p);
+    pixel.contrib_sum += l * filter_weight;
+    pixel.filter_weight_sum += filter_weight;
+  }
+
+  FilmTilePixel &GetPixel(const Point2i &p) {
+    int width = pixel_bounds.pmax.x - pixel_bounds.pmin.x;
+    int offset =
+        (p.x - pixel_bounds.pmin.x) + (p.y - pixel_bounds.pmin.y) * width;
+    return pixels[offset];
+  }
+
+  const FilmTilePixel &GetPixel(const Point2i &p) const {
+    int width = pixel_bounds.pmax.x - pixel_bounds.pmin.x;
+    int offset =
+        (p.x - pixel_bounds.pmin.x) + (p.y - pixel_bounds.pmin.y) * width;
+    return pixels[offset];
+  }
+  Bounds2i GetPixelBounds() const { return pixel_bounds; }
+};
+
 class Film : public Unit {
   struct Pixel {
     Pixel() { value = Spectrum(0.f); filter_weight_sum = 0; }
     Spectrum value;
     Float filter_weight_sum;
+    AtomicFloat splat[3];
   };
   std::unique_ptr<Pixel[]> pixels;
   static constexpr int filter_table_width = 16;
   Float filter_table[filter_table_width * filter_table_width];
-  std::mutex mutex;
+  bool constant_filter;
+  std::unique_ptr<FilterSampler> filter_sampler;
+  // One lock per film row so that tiles touching disjoint rows merge concurrently
+  std::unique_ptr<std::mutex[]> row_mutexes;
   Float scale;
   Float max_sample_luminance;
 
@@ -39,16 +193,23 @@ class Film : public Unit {
   Float diagonal;
   std::string filename;
   Bounds2i cropped_pixel_bounds;
+  // Draw pfilm offsets from the filter instead of splatting over its radius
+  bool importance_sample_filter = false;
 
   void Initialize(const Point2i &resolution, const Bounds2f &crop_window,
                   std::unique_ptr<Filter> filt, Float diagona,
-                  const std::string &filenam, Float scal, Float max_sample_luminanc) {
+                  const std::string &filenam, Float scal, Float max_sample_luminanc,
+                  bool importance_sample_filte = false) {
     full_resolution = resolution;
     diagonal = diagona * .001;
     filter = std::move(filt);
+    MIN_ERROR_UNLESS(FilmTile::SupportsFilterRadius(filter->radius),
+                     "Filter radius {} exceeds the supported film tile footprint", filter->radius.ToString());
+    constant_filter = filter->IsConstant();
     filename = filenam;
     scale = scal;
     max_sample_luminance = max_sample_luminanc;
+    importance_sample_filter = importance_sample_filte;
     cropped_pixel_bounds =
         Bounds2i(Point2i(std::ceil(full_resolution.x * crop_window.pmin.x),
                          std::ceil(full_resolution.y * crop_window.pmin.y)),
@@ -58,6 +219,8 @@ class Film : public Unit {
 
     // Allocate film image storage
     pixels = std::unique_ptr<Pixel[]>(new Pixel[cropped_pixel_bounds.Area()]);
+    row_mutexes = std::unique_ptr<std::mutex[]>(
+        new std::mutex[std::max(0, cropped_pixel_bounds.Diagonal().y)]);
 
     // Precompute filter weight table
     int offset = 0;
@@ -69,13 +232,25 @@ class Film : public Unit {
         filter_table[offset] = filter->Evaluate(p);
       }
     }
+    if (importance_sample_filter)
+      filter_sampler = std::make_unique<FilterSampler>(filter.get());
+  }
+  // Radius over which a sample touches film pixels
+  Vector2f SplatRadius() const {
+    return importance_sample_filter ? Vector2f(0.5f, 0.5f) : filter->radius;
+  }
+  // Offset from the pixel center and the weight of a filter importance sample
+  Vector2f SampleFilter(const Point2f &u, Float *weight) const {
+    return filter_sampler->Sample(u, weight);
   }
   Bounds2i GetSampleBounds() const;
   Bounds2f GetPhysicalExtent() const;
   std::unique_ptr<FilmTile> GetFilmTile(const Bounds2i &sample_bounds);
   void MergeFilmTile(std::unique_ptr<FilmTile> tile);
+  // Accumulate an unfiltered contribution at an arbitrary film position, safe to call from any thread
+  void AddSplat(const Point2f &p, Spectrum v);
   void SetImage(Spectrum *img) const;
-  std::vector<Spectrum> GetImage();
+  std::vector<Spectrum> GetImage(Float splatScale = 1);
   void WriteImage(Float splatScale = 1);
   void Clear();
   void initialize(const Json &json) override;
@@ -83,74 +258,4 @@ class Film : public Unit {
 
 MIN_INTERFACE(Film)
 
-class FilmTile {
-  const Bounds2i pixel_bounds;
-  const Vector2f filter_radius, inv_filter_radius;
-  const Float *filter_table;
-  const int filter_table_size;
-  std::vector<FilmTilePixel> pixels;
-  const Float max_sample_luminance;
-  friend class Film;
- public:
-  FilmTile(const Bounds2i &pixel_bounds, const Vector2f &filter_radius,
-           const Float *filter_table, int filter_table_size,
-           Float max_sample_luminance)
-      : pixel_bounds(pixel_bounds),
-        filter_radius(filter_radius),
-        inv_filter_radius(1 / filter_radius.x, 1 / filter_radius.y),
-        filter_table(filter_table),
-        filter_table_size(filter_table_size),
-        max_sample_luminance(max_sample_luminance) {
-    pixels = std::vector<FilmTilePixel>(std::max<int>(0, pixel_bounds.Area()));
-  }
-
-  void AddSample(const Point2f& pfilm, Spectrum l, Float sample_weight = 1.) {
-    if (l.y > max_sample_luminance) l *= max_sample_luminance / l.y;
-    Point2f film_discrete = pfilm - Vector2f(0.5f, 0.5f);
-    Point2i p0 = (Point2i)Ceil(film_discrete - filter_radius);
-    Point2i p1 = (Point2i)Floor(film_discrete + filter_radius) + Point2i(1, 1);
-    p0 = Max(p0, pixel_bounds.pmin);
-    p1 = Min(p1, pixel_bounds.pmax);
-    int *ifx = new int[p1.x - p0.x];
-    for (int x = p0.x; x < p1.x; ++x) {
-      Float fx = std::abs((x - film_discrete.x) * inv_filter_radius.x *
-          filter_table_size);
-      ifx[x - p0.x] = std::min<int>((int)std::floor(fx), filter_table_size - 1);
-    }
-    int *ify = new int[p1.y - p0.y];
-    for (int y = p0.y; y < p1.y; ++y) {
-      Float fy = std::abs((y - film_discrete.y) * inv_filter_radius.y *
-          filter_table_size);
-      ify[y - p0.y] = std::min<int>((int)std::floor(fy), filter_table_size - 1);
-    }
-    for (int y = p0.y; y < p1.y; ++y) {
-      for (int x = p0.x; x < p1.x; ++x) {
-        // Evaluate filter value at $(x,y)$ pixel
-        int offset = ify[y - p0.y] * filter_table_size + ifx[x - p0.x];
-        Float filterWeight = filter_table[offset];
-
-        // Update pixel values with filtered sample contribution
-        FilmTilePixel &pixel = GetPixel(Point2i(x, y));
-        pixel.contrib_sum += l * sample_weight * filterWeight;
-        pixel.filter_weight_sum += filterWeight;
-      }
-    }
-  }
-
-  FilmTilePixel &GetPixel(const Point2i &p) {
-    int width = pixel_bounds.pmax.x - pixel_bounds.pmin.x;
-    int offset =
-        (p.x - pixel_bounds.pmin.x) + (p.y - pixel_bounds.pmin.y) * width;
-    return pixels[offset];
-  }
-
-  const FilmTilePixel &GetPixel(const Point2i &p) const {
-    int width = pixel_bounds.pmax.x - pixel_bounds.pmin.x;
-    int offset =
-        (p.x - pixel_bounds.pmin.x) + (p.y - pixel_bounds.pmin.y) * width;
-    return pixels[offset];
-  }
-  Bounds2i GetPixelBounds() const { return pixel_bounds; }
-};
-
 }
@@ -1,6 +1,8 @@
 #pragma once
 
 #include "defs.h"
+#include "geometry.h"
+#include "distribution.h"
 
 namespace min {
 
@@ -8,9 +10,39 @@ class Filter : public Unit {
  public:
   Vector2 radius, inv_radisu;
   virtual Float Evaluate(const Point2 &p) const = 0;
+  // Whether Evaluate returns 1 everywhere inside the radius
+  virtual bool IsConstant() const { return false; }
 };
 MIN_INTERFACE(Filter)
 
-}
+// Draws film offsets proportional to |filter|, samples then carry the signed weight f / pdf
+class FilterSampler {
+  const Filter *filter;
+  Bounds2f domain;
+  std::unique_ptr<Distribution2D> distrib;
+ public:
+  explicit FilterSampler(const Filter *filter, int samples_per_radius = 32)
+      : filter(filter), domain(Point2f(-filter->radius), Point2f(filter->radius)) {
+    int nx = std::max(1, int(samples_per_radius * filter->radius.x));
+    int ny = std::max(1, int(samples_per_radius * filter->radius.y));
+    std::vector<Float> func(nx * ny);
+    for (int y = 0; y < ny; ++y) {
+      for (int x = 0; x < nx; ++x) {
+        Point2f p = domain.Lerp(Point2f((x + 0.5f) / nx, (y + 0.5f) / ny));
+        func[y * nx + x] = std::abs(filter->Evaluate(p));
+      }
+    }
+    distrib = std::make_unique<Distribution2D>(func.data(), nx, ny);
+  }
 
+  Vector2f Sample(const Point2f &u, Float *weight) const {
+    Float pdf;
+    Point2f p = domain.Lerp(distrib->SampleContinuous(u, &pdf));
+    pdf /= domain.Area();
+    *weight = pdf > 0 ? filter->Evaluate(p) / pdf : 0;
+    return Vector2f(p);
+  }
+};
+
+}
 
@@ -1,10 +1,11 @@
 #pragma once
 
-#include <min/visual/defs.h>
+#include "defs.h"
+#include "spectrum.h"
 
 namespace min {
 
-Float FrDielectric(Float cosThetaI, Float etaI, Float etaT) {
+inline Float FrDielectric(Float cosThetaI, Float etaI, Float etaT) {
   cosThetaI = Clamp<Float>(cosThetaI, -1, 1);
   // Potentially swap indices of refraction
   bool entering = cosThetaI > 0.f;
@@ -28,7 +29,7 @@ Float FrDielectric(Float cosThetaI, Float etaI, Float etaT) {
 }
 
 // https://seblagarde.wordpress.com/2013/04/29/memo-on-fresnel-equations/
-Spectrum FrConductor(Float cosThetaI, const Spectrum &etai,
+inline Spectrum FrConductor(Float cosThetaI, const Spectrum &etai,
                      const Spectrum &etat, const Spectrum &k) {
   cosThetaI = Clamp<Float>(cosThetaI, -1, 1);
   Spectrum eta = etat / etai;
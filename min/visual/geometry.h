@@ -30,6 +30,24 @@ class Ray {
   Float time;
 };
 
+// Ray with the two auxiliary rays offset by one pixel in x and y on the film
+class RayDifferential : public Ray {
+ public:
+  RayDifferential() {}
+  RayDifferential(const Point3 &o, const Vector3 &d, Float tmax = kInfinity, Float time = 0.0f)
+      : Ray(o, d, tmax, time) {}
+  RayDifferential(const Ray &ray) : Ray(ray) {}
+  void ScaleDifferentials(Float s) {
+    rx_origin = o + (rx_origin - o) * s;
+    ry_origin = o + (ry_origin - o) * s;
+    rx_direction = d + (rx_direction - d) * s;
+    ry_direction = d + (ry_direction - d) * s;
+  }
+  bool has_differentials = false;
+  Point3 rx_origin, ry_origin;
+  Vector3 rx_direction, ry_direction;
+};
+
 inline Point3f OffsetRayOrigin(const Point3f &p, const Vector3f &pError,
                                const Normal3f &n, const Vector3f &w) {
   Float d = Dot(Abs(n), pError);
@@ -77,6 +95,11 @@ class Bounds2 {
     return (d.x * d.y);
   }
 
+  Point2<T> Lerp(const Point2f &t) const {
+    return Point2<T>(min::Lerp(t.x, pmin.x, pmax.x),
+                     min::Lerp(t.y, pmin.y, pmax.y));
+  }
+
   std::string ToString() const {
     return fmt::format("[min={}, pmax={}]", pmin.ToString(), pmax.ToString());
   }
@@ -256,6 +279,47 @@ Bounds3<T> Union(const Bounds3<T> &b, const Bounds3<T> &b2) {
   return ret;
 }
 
+// Set of directions within angle acos(cos_theta) of w
+struct DirectionCone {
+  Vector3f w;
+  Float cos_theta = kInfinity;
+
+  DirectionCone() = default;
+  DirectionCone(const Vector3f &w, Float cos_theta) : w(Normalize(w)), cos_theta(cos_theta) {}
+  explicit DirectionCone(const Vector3f &w) : DirectionCone(w, 1) {}
+
+  bool IsEmpty() const { return cos_theta == kInfinity; }
+  static DirectionCone EntireSphere() { return DirectionCone(Vector3f(0, 0, 1), -1); }
+};
+
+inline DirectionCone Union(const DirectionCone &a, const DirectionCone &b) {
+  if (a.IsEmpty()) return b;
+  if (b.IsEmpty()) return a;
+  // Return the cone that already contains the other one
+  Float theta_a = SafeACos(a.cos_theta), theta_b = SafeACos(b.cos_theta);
+  Float theta_d = SafeACos(Dot(a.w, b.w));
+  if (std::min(theta_d + theta_b, kPi) <= theta_a) return a;
+  if (std::min(theta_d + theta_a, kPi) <= theta_b) return b;
+
+  // Rotate a.w towards b.w so that the merged cone spans both
+  Float theta_o = (theta_a + theta_d + theta_b) / 2;
+  if (theta_o >= kPi) return DirectionCone::EntireSphere();
+  Float theta_r = theta_o - theta_a;
+  Vector3f wr = Cross(a.w, b.w);
+  if (wr.LengthSquared() == 0) return DirectionCone::EntireSphere();
+  wr = Normalize(wr);
+  Vector3f w = a.w * std::cos(theta_r) + Cross(wr, a.w) * std::sin(theta_r);
+  return DirectionCone(w, std::cos(theta_o));
 }
 
+// Cone of directions from p that contains the bounds
+inline DirectionCone BoundSubtendedDirections(const Bounds3f &b, const Point3f &p) {
+  Point3f center = (b.pmin + b.pmax) * 0.5f;
+  Float radius2 = (b.pmax - center).LengthSquared();
+  Float dist2 = (p - center).LengthSquared();
+  if (dist2 < radius2) return DirectionCone::EntireSphere();
+  Float sin2_theta_max = radius2 / dist2;
+  return DirectionCone(center - p, SafeSqrt(1 - sin2_theta_max));
+}
 
+}
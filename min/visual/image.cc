@@ -93,10 +93,13 @@ void WriteImage(const std::string &name,
   }
 }
 
-std::unique_ptr<Vector3[]> ReadImage(const std::string &name, int &width, int &height) {
+std::unique_ptr<Vector3[]> ReadImage(const std::string &name, int &width, int &height, TexelFormat *format) {
   if (HasExtension(name, "png")) {
+    if (format) *format = TexelFormat::kRGB8;
     return std::unique_ptr<Vector3[]>(ReadImagePNG(name, width, height));
   } else if (HasExtension(name, "exr")) {
+    // Rgba channels are half already
+    if (format) *format = TexelFormat::kHalf;
     return std::unique_ptr<Vector3[]>(ReadImageEXR(name, width, height));
   }
   MIN_ERROR("Unable to load image {}", name);
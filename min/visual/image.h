@@ -2,6 +2,7 @@
 
 #include "defs.h"
 #include "geometry.h"
+#include "texel.h"
 
 namespace min {
 
@@ -17,7 +18,9 @@ inline bool HasExtension(const std::string &value, const std::string &ending) {
 extern void WriteImage(const std::string &name, const Float *rgb,
                 const Bounds2i &output_bounds, const Point2i &total_resolution);
 
-extern std::unique_ptr<Vector3[]> ReadImage(const std::string &name, int &width, int &height);
+// format receives the most compact texel format that holds the source data without loss
+extern std::unique_ptr<Vector3[]> ReadImage(const std::string &name, int &width, int &height,
+                                            TexelFormat *format = nullptr);
 
 }
 
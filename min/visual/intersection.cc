@@ -3,9 +3,86 @@
 
 namespace min {
 
-void SurfaceIntersection::ComputeScatteringEvents() {
-  shape->material->ComputeScatteringEvents(*this);
+static bool SolveLinearSystem2x2(const Float A[2][2], const Float B[2], Float *x0, Float *x1) {
+  Float det = A[0][0] * A[1][1] - A[0][1] * A[1][0];
+  if (std::abs(det) < 1e-10f) return false;
+  *x0 = (A[1][1] * B[0] - A[0][1] * B[1]) / det;
+  *x1 = (A[0][0] * B[1] - A[1][0] * B[0]) / det;
+  if (std::isnan(*x0) || std::isnan(*x1)) return false;
+  return true;
 }
 
+void SurfaceIntersection::ComputeScatteringEvents(MemoryArena &arena) {
+  shape->material->ComputeScatteringEvents(*this, arena);
 }
 
+void SurfaceIntersection::ComputeDifferentials(const RayDifferential &ray) {
+  sp.dudx = sp.dvdx = sp.dudy = sp.dvdy = 0;
+  dpdx = dpdy = Vector3(0);
+  if (!ray.has_differentials) return;
+  // Intersect the auxiliary rays with the tangent plane at p
+  const Normal3 &n = geo_frame.n;
+  Float d = Dot(n, p);
+  Float tx = -(Dot(n, ray.rx_origin) - d) / Dot(n, ray.rx_direction);
+  Float ty = -(Dot(n, ray.ry_origin) - d) / Dot(n, ray.ry_direction);
+  if (std::isinf(tx) || std::isnan(tx) || std::isinf(ty) || std::isnan(ty)) return;
+  dpdx = ray.rx_origin + tx * ray.rx_direction - p;
+  dpdy = ray.ry_origin + ty * ray.ry_direction - p;
+  // Solve dp = dpdu du + dpdv dv on the two axes least aligned with n
+  int dim[2];
+  if (std::abs(n.x) > std::abs(n.y) && std::abs(n.x) > std::abs(n.z)) {
+    dim[0] = 1;
+    dim[1] = 2;
+  } else if (std::abs(n.y) > std::abs(n.z)) {
+    dim[0] = 0;
+    dim[1] = 2;
+  } else {
+    dim[0] = 0;
+    dim[1] = 1;
+  }
+  Float A[2][2] = {{dpdu[dim[0]], dpdv[dim[0]]},
+                   {dpdu[dim[1]], dpdv[dim[1]]}};
+  Float Bx[2] = {dpdx[dim[0]], dpdx[dim[1]]};
+  Float By[2] = {dpdy[dim[0]], dpdy[dim[1]]};
+  if (!SolveLinearSystem2x2(A, Bx, &sp.dudx, &sp.dvdx)) sp.dudx = sp.dvdx = 0;
+  if (!SolveLinearSystem2x2(A, By, &sp.dudy, &sp.dvdy)) sp.dudy = sp.dvdy = 0;
+}
+
+RayDifferential SurfaceIntersection::SpawnRayDifferential(const RayDifferential &ray, const Vector3 &wi,
+                                                          BxDFFlags::Type sampled_type) const {
+  RayDifferential rd(SpawnRay(wi));
+  // Footprints after glossy or diffuse scattering are not tracked
+  if (!ray.has_differentials || !(sampled_type & BxDFFlags::kSpecular)) return rd;
+  Normal3 ns = shading_frame.n;
+  Normal3 dndx = dndu * sp.dudx + dndv * sp.dvdx;
+  Normal3 dndy = dndu * sp.dudy + dndv * sp.dvdy;
+  Vector3 dwodx = -ray.rx_direction - wo, dwody = -ray.ry_direction - wo;
+  rd.has_differentials = true;
+  rd.rx_origin = p + dpdx;
+  rd.ry_origin = p + dpdy;
+  if (sampled_type & BxDFFlags::kReflection) {
+    Float dDNdx = Dot(dwodx, ns) + Dot(wo, dndx);
+    Float dDNdy = Dot(dwody, ns) + Dot(wo, dndy);
+    rd.rx_direction = wi - dwodx + 2.f * (Dot(wo, ns) * dndx + dDNdx * ns);
+    rd.ry_direction = wi - dwody + 2.f * (Dot(wo, ns) * dndy + dDNdy * ns);
+  } else {
+    // Without a bsdf the ray passes straight through, eta = 1 keeps the differentials unchanged
+    Float eta = bsdf ? 1 / bsdf->eta : 1;
+    if (Dot(wo, ns) < 0) {
+      eta = 1 / eta;
+      ns = -ns;
+      dndx = -dndx;
+      dndy = -dndy;
+    }
+    Float dDNdx = Dot(dwodx, ns) + Dot(wo, dndx);
+    Float dDNdy = Dot(dwody, ns) + Dot(wo, dndy);
+    Float mu = eta * Dot(wo, ns) - AbsDot(wi, ns);
+    Float dmudx = (eta - (eta * eta * Dot(wo, ns)) / AbsDot(wi, ns)) * dDNdx;
+    Float dmudy = (eta - (eta * eta * Dot(wo, ns)) / AbsDot(wi, ns)) * dDNdy;
+    rd.rx_direction = wi - eta * dwodx + (mu * dndx + dmudx * ns);
+    rd.ry_direction = wi - eta * dwody + (mu * dndy + dmudy * ns);
+  }
+  return rd;
+}
+
+}
@@ -39,8 +39,12 @@ class SurfaceIntersection : public Intersection {
  public:
   Frame shading_frame;
   const Shape *shape = nullptr;
-  std::unique_ptr<BSDF> bsdf = nullptr;
+  BSDF *bsdf = nullptr;
   int face_index = 0;
+  // Parametric derivatives filled by the shape, screen-space ones by ComputeDifferentials
+  Vector3 dpdu, dpdv;
+  Normal3 dndu, dndv;
+  Vector3 dpdx, dpdy;
 
   Vector3f ToLocal(const Vector3f &d) const {
     return shading_frame.ToLocal(d);
@@ -50,7 +54,14 @@ class SurfaceIntersection : public Intersection {
     return shading_frame.ToWorld(d);
   }
 
-  void ComputeScatteringEvents();
+  void ComputeScatteringEvents(MemoryArena &arena);
+
+  // Estimates the uv footprint of the pixel in sp from the auxiliary rays
+  void ComputeDifferentials(const RayDifferential &ray);
+
+  // Spawns the continuation along wi, specular bounces propagate the differentials of ray
+  RayDifferential SpawnRayDifferential(const RayDifferential &ray, const Vector3 &wi,
+                                       BxDFFlags::Type sampled_type) const;
 
 };
 
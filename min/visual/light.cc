@@ -3,6 +3,54 @@
 
 namespace min {
 
+Float LightBounds::Importance(const Point3 &p, const Normal3 &n) const {
+  // cos(max(0, a - b)) and sin(max(0, a - b)) from sines and cosines of a and b
+  auto cos_sub_clamped = [](Float sin_a, Float cos_a, Float sin_b, Float cos_b) -> Float {
+    if (cos_a > cos_b) return 1;
+    return cos_a * cos_b + sin_a * sin_b;
+  };
+  auto sin_sub_clamped = [](Float sin_a, Float cos_a, Float sin_b, Float cos_b) -> Float {
+    if (cos_a > cos_b) return 0;
+    return sin_a * cos_b - cos_a * sin_b;
+  };
+
+  // Clamp the squared distance so that points inside the bounds stay finite
+  Point3 pc = Centroid();
+  Float d2 = (p - pc).LengthSquared();
+  d2 = std::max(d2, bounds.Diagonal().Length() / 2);
+
+  Vector3 wi = Normalize(p - pc);
+  Float cos_theta_w = Dot(w, wi);
+  if (two_sided) cos_theta_w = std::abs(cos_theta_w);
+  Float sin_theta_w = SafeSqrt(1 - cos_theta_w * cos_theta_w);
+
+  // Smallest angle between the emission cone and any direction towards p
+  Float cos_theta_b = BoundSubtendedDirections(bounds, p).cos_theta;
+  Float sin_theta_b = SafeSqrt(1 - cos_theta_b * cos_theta_b);
+  Float sin_theta_o = SafeSqrt(1 - cos_theta_o * cos_theta_o);
+  Float cos_theta_x = cos_sub_clamped(sin_theta_w, cos_theta_w, sin_theta_o, cos_theta_o);
+  Float sin_theta_x = sin_sub_clamped(sin_theta_w, cos_theta_w, sin_theta_o, cos_theta_o);
+  Float cos_theta_p = cos_sub_clamped(sin_theta_x, cos_theta_x, sin_theta_b, cos_theta_b);
+  if (cos_theta_p <= cos_theta_e) return 0;
+
+  Float importance = phi * cos_theta_p / d2;
+  // Account for the receiver's cosine at surface points
+  if (n.LengthSquared() > 0) {
+    Float cos_theta_i = AbsDot(wi, n);
+    Float sin_theta_i = SafeSqrt(1 - cos_theta_i * cos_theta_i);
+    importance *= cos_sub_clamped(sin_theta_i, cos_theta_i, sin_theta_b, cos_theta_b);
+  }
+  return std::max<Float>(importance, 0);
+}
+
+LightBounds Union(const LightBounds &a, const LightBounds &b) {
+  if (a.phi == 0) return b;
+  if (b.phi == 0) return a;
+  DirectionCone cone = Union(DirectionCone(a.w, a.cos_theta_o), DirectionCone(b.w, b.cos_theta_o));
+  return LightBounds(Union(a.bounds, b.bounds), cone.w, a.phi + b.phi, cone.cos_theta,
+                     std::min(a.cos_theta_e, b.cos_theta_e), a.two_sided || b.two_sided);
+}
+
 bool VisibilityTester::Unoccluded(const std::shared_ptr<Scene> &scene) const {
   return !scene->IntersectP(p0.SpwanRayTo(p1));
 }
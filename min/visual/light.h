@@ -33,6 +33,26 @@ struct LightRaySample {
   Float pdf_dir;
 };
 
+// Spatial and directional extent of a light's emission, used to estimate its contribution at a point
+struct LightBounds {
+  Bounds3f bounds;
+  Float phi = 0;
+  Vector3 w;
+  Float cos_theta_o, cos_theta_e;
+  bool two_sided = false;
+
+  LightBounds() = default;
+  LightBounds(const Bounds3f &bounds, const Vector3 &w, Float phi, Float cos_theta_o,
+              Float cos_theta_e, bool two_sided)
+      : bounds(bounds), phi(phi), w(Normalize(w)), cos_theta_o(cos_theta_o),
+        cos_theta_e(cos_theta_e), two_sided(two_sided) {}
+
+  Point3 Centroid() const { return (bounds.pmin + bounds.pmax) * 0.5f; }
+  Float Importance(const Point3 &p, const Normal3 &n) const;
+};
+
+LightBounds Union(const LightBounds &a, const LightBounds &b);
+
 class Light : public Unit{
  protected:
   Transform light2world, world2light;
@@ -42,11 +62,20 @@ class Light : public Unit{
   virtual void Preprocess(const Scene &scene) {}
   virtual void SampleLi(const Point2f &u, const Intersection &isect, LightSample &sample, VisibilityTester &tester) const = 0;
   virtual Float PdfLi(const Intersection &isect, const Vector3 &wi) const = 0;
+  // Same density when the emitter hit along wi has already been found
+  virtual Float PdfLi(const Intersection &isect, const SurfaceIntersection &light_isect) const {
+    return PdfLi(isect, Normalize(light_isect.p - isect.p));
+  }
   virtual void SampleLe(const Point2f &u1, const Point2f &u2, LightRaySample &sample) const = 0;
   virtual Float PdfLe(const Ray &ray, const Normal3f &n_light) const = 0;
   virtual void SetShape(const std::shared_ptr<Shape> &shape) {}
+  virtual void SetShapes(const std::vector<std::shared_ptr<Shape>> &shapes) {}
   virtual Spectrum Le(const Ray &ray) const { return Spectrum(0); }
   virtual Spectrum L(const Intersection &isect, const Vector3 &w) const { return Spectrum(0); }
+  // Total emitted power
+  virtual Spectrum Power() const { return Spectrum(0); }
+  // Returns false for lights without finite spatial bounds
+  virtual bool Bounds(LightBounds &bounds) const { return false; }
 };
 MIN_INTERFACE(Light)
 
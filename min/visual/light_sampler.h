@@ -0,0 +1,19 @@
+#pragma once
+
+#include "defs.h"
+#include "light.h"
+
+namespace min {
+
+// Chooses one light for next event estimation at a shading point
+class LightSampler : public Unit {
+ public:
+  virtual void Build(const std::vector<std::shared_ptr<Light>> &lights) = 0;
+  // Returns nullptr if no light can contribute at ref
+  virtual const Light *Sample(const Intersection &ref, Float u, Float *pmf) const = 0;
+  virtual Float Pmf(const Intersection &ref, const Light *light) const = 0;
+};
+MIN_INTERFACE(LightSampler)
+
+}
+
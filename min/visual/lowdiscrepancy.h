@@ -0,0 +1,105 @@
+#pragma once
+
+#include "defs.h"
+#include "rng.h"
+#include <array>
+
+namespace min {
+
+inline uint32_t ReverseBits32(uint32_t n) {
+  n = (n << 16U) | (n >> 16U);
+  n = ((n & 0x00ff00ffU) << 8U) | ((n & 0xff00ff00U) >> 8U);
+  n = ((n & 0x0f0f0f0fU) << 4U) | ((n & 0xf0f0f0f0U) >> 4U);
+  n = ((n & 0x33333333U) << 2U) | ((n & 0xccccccccU) >> 2U);
+  n = ((n & 0x55555555U) << 1U) | ((n & 0xaaaaaaaaU) >> 1U);
+  return n;
+}
+
+// Kensler's hashed permutation, element i of the permutation of [0, l) selected by p
+inline int PermutationElement(uint32_t i, uint32_t l, uint32_t p) {
+  uint32_t w = l - 1;
+  w |= w >> 1U;
+  w |= w >> 2U;
+  w |= w >> 4U;
+  w |= w >> 8U;
+  w |= w >> 16U;
+  do {
+    i ^= p;
+    i *= 0xe170893dU;
+    i ^= p >> 16U;
+    i ^= (i & w) >> 4U;
+    i ^= p >> 8U;
+    i *= 0x0929eb3fU;
+    i ^= p >> 23U;
+    i ^= (i & w) >> 1U;
+    i *= 1U | p >> 27U;
+    i *= 0x6935fa69U;
+    i ^= (i & w) >> 11U;
+    i *= 0x74dcb303U;
+    i ^= (i & w) >> 2U;
+    i *= 0x9e501cc3U;
+    i ^= (i & w) >> 2U;
+    i *= 0xc860a3dfU;
+    i &= w;
+    i ^= i >> 5U;
+  } while (i >= l);
+  return int((i + p) % l);
+}
+
+struct NoRandomizer {
+  uint32_t operator()(uint32_t v) const { return v; }
+};
+
+// Nested uniform scrambling, every bit is flipped by a hash of the bits above it
+struct OwenScrambler {
+  uint32_t seed;
+  explicit OwenScrambler(uint32_t seed) : seed(seed) {}
+  uint32_t operator()(uint32_t v) const {
+    if (seed & 1U) v ^= 1U << 31U;
+    for (int b = 1; b < 32; ++b) {
+      uint32_t mask = (~0U) << uint32_t(32 - b);
+      if (uint32_t(MixBits((v & mask) ^ seed)) & (1U << uint32_t(b))) v ^= 1U << uint32_t(31 - b);
+    }
+    return v;
+  }
+};
+
+// Owen scrambling with a hash in which every bit only depends on the bits above it (Laine-Karras)
+struct FastOwenScrambler {
+  uint32_t seed;
+  explicit FastOwenScrambler(uint32_t seed) : seed(seed) {}
+  uint32_t operator()(uint32_t v) const {
+    v = ReverseBits32(v);
+    v ^= v * 0x3d20adeaU;
+    v += seed;
+    v *= (seed >> 16U) | 1U;
+    v ^= v * 0x05526c56U;
+    v ^= v * 0x53a22864U;
+    return ReverseBits32(v);
+  }
+};
+
+// Generator matrix columns of the second Sobol dimension, the first is the van der Corput sequence
+inline constexpr std::array<uint32_t, 32> MakeSobolMatrix1() {
+  std::array<uint32_t, 32> c{};
+  c[0] = 1U << 31U;
+  for (int i = 1; i < 32; ++i) c[i] = c[i - 1] ^ (c[i - 1] >> 1U);
+  return c;
+}
+inline constexpr std::array<uint32_t, 32> kSobolMatrix1 = MakeSobolMatrix1();
+
+// Point a of the 2D Sobol sequence in dimension 0 or 1
+template <typename Randomizer>
+Float SobolSample(uint32_t a, int dimension, Randomizer randomize) {
+  uint32_t v = 0;
+  if (dimension == 0) {
+    v = ReverseBits32(a);
+  } else {
+    for (int i = 0; a != 0; a >>= 1U, ++i)
+      if (a & 1U) v ^= kSobolMatrix1[i];
+  }
+  v = randomize(v);
+  return std::min<Float>(v * 0x1p-32f, kOneMinusEpsilon);
+}
+
+}
@@ -3,48 +3,23 @@
 #include "defs.h"
 #include "spectrum.h"
 #include "frame.h"
+#include "bxdf.h"
+#include <min/common/memory.h>
 
 namespace min {
 
-class BxDF {
- public:
-  enum Type {
-    kNone = 0,
-    kDiffuse = 1ULL,
-    kGlossy = 1ULL << 1U,
-    kReflection = 1ULL << 2U,
-    kTransmission = 1ULL << 3U,
-    kSpecular = 1ULL << 4U,
-    kAll = kDiffuse | kGlossy | kTransmission | kSpecular | kReflection,
-    kAllButSpecular = kAll & ~kSpecular
-  };
-  const Type type;
-  explicit BxDF(Type type) : type(type) {}
-  bool MatchesFlags(Type t) const { return (type & t) == type; }
-  virtual Spectrum Evaluate(const Vector3f &wo, const Vector3f &wi) const = 0;
-  virtual void Sample(const Point2f &u, const Vector3f &wo, BSDFSample &sample) const;
-  virtual Float Pdf(const Vector3 &wo, const Vector3 &wi) const;
-};
-
-struct BSDFSample {
-  Vector3f wi;
-  Float pdf;
-  Spectrum f;
-  BxDF::Type sampled_type = BxDF::Type::kNone;
-};
-
 class BSDF {
  public:
   BSDF(const Frame geo_frame, const Frame shading_frame, Float eta = 1.0f) : geo_frame(geo_frame), shading_frame(shading_frame), eta(eta) {}
-  void Add(const std::shared_ptr<BxDF> &b) {
-    MIN_ASSERT(num_bxdfs <= kMaxBxDFs);
-    num_bxdfs++;
-    bxdfs.emplace_back(b);
+  template <typename Lobe>
+  void Add(const Lobe &lobe) {
+    MIN_ASSERT(num_bxdfs < kMaxBxDFs);
+    new (&bxdfs[num_bxdfs++]) BxDF(lobe);
   }
   int NumComponents(BxDF::Type flags = BxDF::Type::kAll) const {
     int num = 0;
     for (int i = 0; i < num_bxdfs; ++i) {
-      if (bxdfs[i]->MatchesFlags(flags)) ++num;
+      if (bxdfs[i].MatchesFlags(flags)) ++num;
     }
     return num;
   }
@@ -60,10 +35,10 @@ class BSDF {
     bool reflect = Dot(wiw, geo_frame.n) * Dot(wow, geo_frame.n) > 0;
     Spectrum f(0);
     for (int i = 0; i < num_bxdfs; i++) {
-      if (bxdfs[i]->MatchesFlags(flags) &&
-          ((reflect && (bxdfs[i]->type & BxDF::Type::kReflection)) ||
-              (!reflect && (bxdfs[i]->type & BxDF::Type::kTransmission)))) {
-        f += bxdfs[i]->Evaluate(wo, wi);
+      if (bxdfs[i].MatchesFlags(flags) &&
+          ((reflect && (bxdfs[i].type & BxDF::Type::kReflection)) ||
+              (!reflect && (bxdfs[i].type & BxDF::Type::kTransmission)))) {
+        f += bxdfs[i].Evaluate(wo, wi);
       }
     }
     return f;
@@ -78,11 +53,11 @@ class BSDF {
       return;
     }
     int comp = std::min((int)std::floor(u[0] * matching_comps), matching_comps - 1);
-    std::shared_ptr<BxDF> bxdf = nullptr;
+    const BxDF *bxdf = nullptr;
     int count = comp;
     for (int i = 0; i < num_bxdfs; i++) {
-      if (bxdfs[i]->MatchesFlags(type) && count-- == 0) {
-        bxdf = bxdfs[i];
+      if (bxdfs[i].MatchesFlags(type) && count-- == 0) {
+        bxdf = &bxdfs[i];
         break;
       }
     }
@@ -106,8 +81,8 @@ class BSDF {
     // Compute overall
     if (!(bxdf->type & BxDF::Type::kSpecular) && matching_comps > 1) {
       for (int i = 0; i < num_bxdfs; i++) {
-        if (bxdfs[i] != bxdf && bxdfs[i]->MatchesFlags(type)) {
-          sample.pdf += bxdfs[i]->Pdf(wo, wi);
+        if (&bxdfs[i] != bxdf && bxdfs[i].MatchesFlags(type)) {
+          sample.pdf += bxdfs[i].Pdf(wo, wi);
         }
       }
     }
@@ -116,10 +91,10 @@ class BSDF {
       bool reflect = Dot(sample.wi, geo_frame.n) * Dot(wow, geo_frame.n) > 0;
       sample.f = Spectrum(0);
       for (int i = 0; i < num_bxdfs; i++) {
-        if (bxdfs[i]->MatchesFlags(type) &&
-            ((reflect && (bxdfs[i]->type & BxDF::Type::kReflection)) ||
-                (!reflect && (bxdfs[i]->type & BxDF::Type::kTransmission)))) {
-          sample.f += bxdfs[i]->Evaluate(wo, wi);
+        if (bxdfs[i].MatchesFlags(type) &&
+            ((reflect && (bxdfs[i].type & BxDF::Type::kReflection)) ||
+                (!reflect && (bxdfs[i].type & BxDF::Type::kTransmission)))) {
+          sample.f += bxdfs[i].Evaluate(wo, wi);
         }
       }
     }
@@ -131,9 +106,9 @@ class BSDF {
     Float pdf = 0;
     int matching_comps = 0;
     for (int i = 0; i < num_bxdfs; i++) {
-      if (bxdfs[i]->MatchesFlags(flags)) {
+      if (bxdfs[i].MatchesFlags(flags)) {
         ++matching_comps;
-        pdf += bxdfs[i]->Pdf(wo, wi);
+        pdf += bxdfs[i].Pdf(wo, wi);
       }
     }
     Float v = matching_comps > 0 ? pdf / matching_comps : 0;
@@ -144,12 +119,13 @@ class BSDF {
   const Frame shading_frame, geo_frame;
   int num_bxdfs = 0;
   static constexpr int kMaxBxDFs = 8;
-  std::vector<std::shared_ptr<BxDF>> bxdfs;
+  BxDF bxdfs[kMaxBxDFs];
 };
 
 class Material : public Unit {
  public:
-  virtual void ComputeScatteringEvents(SurfaceIntersection &si) const = 0;
+  // Allocates si.bsdf and its lobes from arena
+  virtual void ComputeScatteringEvents(SurfaceIntersection &si, MemoryArena &arena) const = 0;
 };
 MIN_INTERFACE(Material)
 
@@ -0,0 +1,245 @@
+#pragma once
+
+#include "defs.h"
+#include "frame.h"
+#include <min/math/fastmath.h>
+
+namespace min {
+
+class MicrofacetDistribution {
+ public:
+  enum Type {
+    kBeckmann = 0,
+    kGGX = 1
+  };
+
+  Type type;
+  Float alpha_x, alpha_y;
+  // Sample only the microfacet normals visible from wo instead of the full D(wh)
+  bool sample_visible;
+  MicrofacetDistribution(Type type, Float alpha, bool sample_visible = true)
+      : type(type), alpha_x(alpha), alpha_y(alpha), sample_visible(sample_visible) {}
+  MicrofacetDistribution(Type type, Float alpha_x, Float alpha_y, bool sample_visible = true)
+      : type(type), alpha_x(alpha_x), alpha_y(alpha_y), sample_visible(sample_visible) {}
+
+  Float Evaluate(const Vector3 &wh) const {
+    Float result;
+    switch (type) {
+      case kBeckmann: {
+        Float tan2theta = Frame::Sin2Theta(wh) / Frame::Cos2Theta(wh);
+        if (std::isinf(tan2theta)) {
+          result = 0.0f;
+          break;
+        }
+        Float cos4theta = Frame::Cos2Theta(wh) * Frame::Cos2Theta(wh);
+        result =
+            MathExp(-tan2theta * (Frame::Cos2Phi(wh) / (alpha_x * alpha_x) + Frame::Sin2Phi(wh) / (alpha_y * alpha_y)))
+                / (kPi * alpha_x * alpha_y * cos4theta);
+        break;
+      }
+      case kGGX : {
+        Float tan2theta = Frame::Sin2Theta(wh) / Frame::Cos2Theta(wh);
+        if (std::isinf(tan2theta)) {
+          result = 0.0f;
+          break;
+        }
+        Float cos4theta = Frame::Cos2Theta(wh) * Frame::Cos2Theta(wh);
+        Float e = (Frame::Cos2Phi(wh) / (alpha_x * alpha_x) + Frame::Sin2Phi(wh) / (alpha_y * alpha_y)) * tan2theta;
+        return 1 / (kPi * alpha_x * alpha_y * cos4theta * (1 + e) * (1 + e));
+      }
+    }
+    return result;
+  }
+
+  Normal3f Sample(const Point2 &u, const Vector3 &wo) const {
+    if (!sample_visible) return SampleAll(u, wo);
+    bool flip = wo.z < 0;
+    Normal3f wh = SampleVisible(u, flip ? -wo : wo);
+    return flip ? -wh : wh;
+  }
+
+  // Sample wh from the full area distribution D(wh)|cos(wh)|
+  Normal3f SampleAll(const Point2 &u, const Vector3 &wo) const {
+    Normal3f result;
+    switch (type) {
+      case kBeckmann: {
+        Float tan2theta, phi;
+        if (alpha_x == alpha_y) {
+          Float log_sample = MathLog(1 - u[0]);
+          if (std::isinf(log_sample)) log_sample = 0;
+          tan2theta = -alpha_x * alpha_y * MathLog(1 - u[0]);
+          phi = u[1] * 2 * kPi;
+        } else {
+          Float log_sample = MathLog(u[0]);
+          phi = std::atan(alpha_y / alpha_x *
+              std::tan(2 * kPi * u[1] + 0.5f * kPi));
+          if (u[1] > 0.5f)
+            phi += kPi;
+          Float sinPhi, cosPhi;
+          MathSinCos(phi, &sinPhi, &cosPhi);
+          Float alphax2 = alpha_x * alpha_x, alphay2 = alpha_y * alpha_y;
+          tan2theta = -log_sample /
+              (cosPhi * cosPhi / alphax2 + sinPhi * sinPhi / alphay2);
+        }
+        Float costheta = 1 / std::sqrt(1 + tan2theta);
+        Float sintheta = std::sqrt(std::max((Float)0, 1 - costheta * costheta));
+        Float sinphi, cosphi;
+        MathSinCos(phi, &sinphi, &cosphi);
+        result = Normal3f(sintheta * cosphi, sintheta * sinphi, costheta);
+        if (result.z * wo.z < 0) result *= -1;
+        break;
+      }
+      case kGGX: {
+        Float costheta = 0, phi = (2 * kPi) * u[1];
+        if (alpha_x == alpha_y) {
+          Float tantheta2 = alpha_x * alpha_x * u[0] / (1.0f - u[0]);
+          costheta = 1 / std::sqrt(1 + tantheta2);
+        } else {
+          phi = std::atan(alpha_y / alpha_x * std::tan(2 * kPi * u[1] + .5f * kPi));
+          if (u[1] > .5f) phi += kPi;
+          Float sinphi, cosPhi;
+          MathSinCos(phi, &sinphi, &cosPhi);
+          const Float alphax2 = alpha_x * alpha_x, alphay2 = alpha_y * alpha_y;
+          const Float alpha2 = 1 / (cosPhi * cosPhi / alphax2 + sinphi * sinphi / alphay2);
+          Float tantheta2 = alpha2 * u[0] / (1 - u[0]);
+          costheta = 1 / std::sqrt(1 + tantheta2);
+        }
+        Float sintheta =
+            std::sqrt(std::max((Float)0., (Float)1. - costheta * costheta));
+        Float sinphi, cosphi;
+        MathSinCos(phi, &sinphi, &cosphi);
+        result = Normal3f(sintheta * cosphi, sintheta * sinphi, costheta);
+        if (result.z * wo.z < 0) result *= -1;
+      }
+    }
+    return result;
+  }
+
+  Float Pdf(const Vector3 &wo, const Vector3 &wh) const {
+    if (sample_visible) {
+      Float costheta_o = Frame::AbsCosTheta(wo);
+      if (costheta_o == 0.f) return 0;
+      return Evaluate(wh) * G1(wo) * AbsDot(wo, wh) / costheta_o;
+    }
+    return Evaluate(wh) * std::abs(Frame::CosTheta(wh));
+  }
+
+  // Ratio of invisible to visible projected microfacet area in direction w
+  Float Lambda(const Vector3 &w) const {
+    Float tantheta = std::abs(Frame::TanTheta(w));
+    if (std::isinf(tantheta)) return 0;
+    if (tantheta == 0.0f) return 0;
+    Float alpha = ProjectRoughness(w);
+    switch (type) {
+      case kBeckmann: {
+        Float a = 1 / (alpha * tantheta);
+        if (a >= 1.6f) return 0;
+        return (1 - 1.259f * a + 0.396f * a * a) / (3.535f * a + 2.181f * a * a);
+      }
+      case kGGX:
+      default: {
+        Float root = alpha * tantheta;
+        return (-1 + std::sqrt(1 + root * root)) * 0.5f;
+      }
+    }
+  }
+
+  Float G1(const Vector3 &w) const {
+    return 1 / (1 + Lambda(w));
+  }
+
+  Float SmithG1(const Vector3 &wo, const Vector3 &wh) const {
+    if (Dot(wo, wh) * Frame::CosTheta(wo) <= 0.f) return 0.0f;
+    return G1(wo);
+  }
+
+  Float SmithG(const Vector3 &wo, const Vector3 &wi, const Vector3 &wh) const {
+    return SmithG1(wi, wh) * SmithG1(wo, wh);
+  }
+
+  inline bool IsIsotropic() const { return alpha_x == alpha_y; }
+
+ protected:
+  // wh visible from wo, wo in the upper hemisphere
+  Normal3f SampleVisible(const Point2 &u, const Vector3 &wo) const {
+    switch (type) {
+      case kBeckmann: {
+        // Sample the slope distribution of the stretched configuration (Heitz and d'Eon 2014)
+        Vector3 wo_stretched = Normalize(Vector3(alpha_x * wo.x, alpha_y * wo.y, wo.z));
+        Float slope_x, slope_y;
+        BeckmannSample11(Frame::CosTheta(wo_stretched), u[0], u[1], &slope_x, &slope_y);
+        Float cosphi = Frame::CosPhi(wo_stretched), sinphi = Frame::SinPhi(wo_stretched);
+        Float tmp = cosphi * slope_x - sinphi * slope_y;
+        slope_y = sinphi * slope_x + cosphi * slope_y;
+        slope_x = tmp;
+        return Normalize(Normal3f(-alpha_x * slope_x, -alpha_y * slope_y, 1.f));
+      }
+      case kGGX:
+      default: {
+        // Sample the projected hemisphere of the stretched configuration (Heitz 2018)
+        Vector3 vh = Normalize(Vector3(alpha_x * wo.x, alpha_y * wo.y, wo.z));
+        Float lensq = vh.x * vh.x + vh.y * vh.y;
+        Vector3 t1 = lensq > 0 ? Vector3(-vh.y, vh.x, 0) * (1 / std::sqrt(lensq)) : Vector3(1, 0, 0);
+        Vector3 t2 = Cross(vh, t1);
+        Float r = std::sqrt(u[0]), phi = 2 * kPi * u[1];
+        Float sinphi, cosphi;
+        MathSinCos(phi, &sinphi, &cosphi);
+        Float p1 = r * cosphi, p2 = r * sinphi;
+        Float s = 0.5f * (1 + vh.z);
+        p2 = (1 - s) * SafeSqrt(1 - p1 * p1) + s * p2;
+        Vector3 nh = p1 * t1 + p2 * t2 + SafeSqrt(1 - p1 * p1 - p2 * p2) * vh;
+        return Normalize(Normal3f(alpha_x * nh.x, alpha_y * nh.y, std::max((Float)1e-6f, nh.z)));
+      }
+    }
+  }
+
+  static void BeckmannSample11(Float costheta, Float u1, Float u2, Float *slope_x, Float *slope_y) {
+    // Special case (normal incidence)
+    if (costheta > .9999f) {
+      Float r = std::sqrt(-MathLog(1.0f - u1));
+      Float sinphi, cosphi;
+      MathSinCos(2 * kPi * u2, &sinphi, &cosphi);
+      *slope_x = r * cosphi;
+      *slope_y = r * sinphi;
+      return;
+    }
+    Float sintheta = SafeSqrt(1 - costheta * costheta);
+    Float tantheta = sintheta / costheta;
+    Float cottheta = 1 / tantheta;
+    // Search interval for the inverted slope cdf, with a fitted initial guess
+    Float a = -1, c = std::erf(cottheta);
+    Float sample_x = std::max(u1, (Float)1e-6f);
+    Float theta = MathACos(costheta);
+    Float fit = 1 + theta * (-0.876f + theta * (0.4265f - 0.0594f * theta));
+    Float b = c - (1 + c) * std::pow(1 - sample_x, fit);
+    const Float inv_sqrt_pi = 1.f / std::sqrt(kPi);
+    Float normalization = 1 / (1 + c + inv_sqrt_pi * tantheta * MathExp(-cottheta * cottheta));
+    // Newton-bisection
+    for (int it = 1; it < 10; ++it) {
+      if (!(b >= a && b <= c)) b = 0.5f * (a + c);
+      Float inv_erf = ErfInv(b);
+      Float value = normalization * (1 + b + inv_sqrt_pi * tantheta * MathExp(-inv_erf * inv_erf)) - sample_x;
+      Float derivative = normalization * (1 - inv_erf * tantheta);
+      if (std::abs(value) < 1e-5f) break;
+      if (value > 0) c = b;
+      else a = b;
+      b -= value / derivative;
+    }
+    *slope_x = ErfInv(b);
+    *slope_y = ErfInv(2.0f * std::max(u2, (Float)1e-6f) - 1.0f);
+  }
+
+  inline Float ProjectRoughness(const Vector3 &v) const {
+    Float invSinTheta2 = 1 / Frame::Sin2Theta(v);
+
+    if (IsIsotropic() || invSinTheta2 <= 0)
+      return alpha_x;
+
+    Float cosPhi2 = v.x * v.x * invSinTheta2;
+    Float sinPhi2 = v.y * v.y * invSinTheta2;
+
+    return std::sqrt(cosPhi2 * alpha_x * alpha_x + sinPhi2 * alpha_y * alpha_y);
+  }
+};
+
+}
\ No newline at end of file
@@ -1,12 +1,14 @@
 #pragma once
 
 #include <min/common/memory.h>
+#include <min/common/parallel.h>
+#include <min/common/cpu.h>
 #include "defs.h"
+#include "texel.h"
+#include "texture_cache.h"
 
 namespace min {
 
-enum ImageWrapMode { kRepeat, kBlack, kClamp};
-
 template <typename T, int logBlockSize = 2>
 class BlockedArray {
  public:
@@ -63,13 +65,43 @@ struct ResampleWeight {
 };
 
 class MIPMap {
+  friend class TextureCache;
  private:
+  // Streams texels from the TextureCache instead of the pyramids below
+  TextureCache::Texture *cached = nullptr;
   const ImageWrapMode wrap_mode;
+  const TexelFormat format;
   Point2i resolution;
+  std::vector<Point2i> level_resolution;
+  // Only the pyramid matching format is populated
   std::vector<std::unique_ptr<BlockedArray<Vector3>>> pyramid;
+  std::vector<std::unique_ptr<BlockedArray<TexelRGB8>>> pyramid8;
+  std::vector<std::unique_ptr<BlockedArray<TexelHalf>>> pyramid16;
  public:
-  MIPMap(const Point2i res, const Vector3 *img, ImageWrapMode wrap_mode = ImageWrapMode::kRepeat)
-    : resolution(res), wrap_mode(wrap_mode) {
+  MIPMap(const Point2i res, const Vector3 *img, ImageWrapMode wrap_mode = ImageWrapMode::kRepeat,
+         TexelFormat format = TexelFormat::kFloat)
+    : resolution(res), wrap_mode(wrap_mode), format(format) {
+    BuildLevels(res, img, wrap_mode, [&](int i, int levels, const Point2i &level_res, const Vector3 *data) {
+      if (i == 0) {
+        resolution = level_res;
+        level_resolution.resize(levels);
+        switch (format) {
+          case TexelFormat::kRGB8:
+          case TexelFormat::kSRGB8: pyramid8.resize(levels); break;
+          case TexelFormat::kHalf: pyramid16.resize(levels); break;
+          default: pyramid.resize(levels);
+        }
+      }
+      level_resolution[i] = level_res;
+      StoreLevel(i, data);
+    });
+  }
+
+  // Filters img into the levels of a pyramid, after resampling it to power of two resolutions.
+  // store(level, levels, resolution, texels) receives every level in full precision, finest first.
+  // At most two filtered levels are alive at a time and img is not read after level 1 was stored.
+  template <typename F>
+  static void BuildLevels(Point2i resolution, const Vector3 *img, ImageWrapMode wrap_mode, F &&store) {
     std::unique_ptr<Vector3[]> resampled_image = nullptr;
     if (!IsPowerOf2(resolution[0]) || !IsPowerOf2(resolution[1])) {
       Point2i res_resampled(RoundUpPow2(resolution[0]), RoundUpPow2(resolution[1]));
@@ -79,7 +111,7 @@ class MIPMap {
       std::unique_ptr<ResampleWeight[]> s_weights =
           ResampleWeights(resolution[0], res_resampled[0]);
       resampled_image.reset(new Vector3[res_resampled[0] * res_resampled[1]]);
-      for (int t = 0; t < resolution[1]; t++) {
+      ParallelFor([&](int64_t t) {
         for (int s = 0; s < res_resampled[0]; ++s) {
           // Compute texel $(s,t)$ in $s$-zoomed image
           resampled_image[t * res_resampled[0] + s] = Vector3(0.f);
@@ -87,7 +119,7 @@ class MIPMap {
             int origS = s_weights[s].first_texel + j;
             if (wrap_mode == ImageWrapMode::kRepeat)
               origS = Mod(origS, resolution[0]);
-            else if (wrap_mode == ImageWrapMode::kClamp)
+            else if (wrap_mode == ImageWrapMode::kClamp || wrap_mode == ImageWrapMode::kOctahedral)
               origS = Clamp(origS, 0, resolution[0] - 1);
             if (origS >= 0 && origS < (int)resolution[0])
               resampled_image[t * res_resampled[0] + s] +=
@@ -95,11 +127,11 @@ class MIPMap {
                       img[t * resolution[0] + origS];
           }
         }
-      }
+      }, resolution[1]);
       // Resample in t direction
       std::unique_ptr<ResampleWeight[]> t_weights =
           ResampleWeights(resolution[1], res_resampled[1]);
-      for (int s = 0; s < res_resampled[0]; s++) {
+      ParallelFor([&](int64_t s) {
         std::unique_ptr<Vector3[]> work_data(new Vector3[res_resampled[1]]);
         for (int t = 0; t < res_resampled[1]; ++t) {
           work_data[t] = Vector3(0.f);
@@ -107,7 +139,7 @@ class MIPMap {
             int offset = t_weights[t].first_texel + j;
             if (wrap_mode == ImageWrapMode::kRepeat)
               offset = Mod(offset, resolution[1]);
-            else if (wrap_mode == ImageWrapMode::kClamp)
+            else if (wrap_mode == ImageWrapMode::kClamp || wrap_mode == ImageWrapMode::kOctahedral)
               offset = Clamp(offset, 0, (int)resolution[1] - 1);
             if (offset >= 0 && offset < (int)resolution[1])
               work_data[t] += t_weights[t].weight[j] *
@@ -115,78 +147,172 @@ class MIPMap {
           }
         }
         for (int t = 0; t < res_resampled[1]; ++t)
-          resampled_image[t * res_resampled[0] + s] = Clamp(work_data[t], Vector3(0.f), Vector3(kInfinity));
-      }
+          resampled_image[t * res_resampled[0] + s] = Max(work_data[t], Vector3(0.f));
+      }, res_resampled[0]);
       resolution = res_resampled;
     }
     // Initialize levels of details
     int levels = 1 + Log2Int(std::max(resolution[0], resolution[1]));
-    pyramid.resize(levels);
-    // Initialize most detailed level of MIPMap
-    pyramid[0].reset(
-        new BlockedArray<Vector3>(resolution[0], resolution[1],
-                            resampled_image ? resampled_image.get() : img));
+    const Vector3 *level = resampled_image ? resampled_image.get() : img;
+    std::unique_ptr<Vector3[]> finer, coarser;
+    Point2i fine_res = resolution;
+    store(0, levels, fine_res, level);
     for (int i = 1; i < levels; ++i) {
       // Initialize $i$th MIPMap level from $i-1$st level
-      int sRes = std::max(1, pyramid[i - 1]->uSize() / 2);
-      int tRes = std::max(1, pyramid[i - 1]->vSize() / 2);
-      pyramid[i].reset(new BlockedArray<Vector3>(sRes, tRes));
+      int sRes = std::max(1, fine_res[0] / 2);
+      int tRes = std::max(1, fine_res[1] / 2);
+      coarser.reset();
+      coarser.reset(new Vector3[sRes * tRes]);
 
       // Filter four texels from finer level of pyramid
-      for (int t = 0; t < tRes; t++) {
+      auto fine_texel = [&](int s, int t) {
+        if (!WrapCoordinates(wrap_mode, fine_res, s, t)) return Vector3(0.f);
+        return level[t * fine_res[0] + s];
+      };
+      ParallelFor([&](int64_t t) {
         for (int s = 0; s < sRes; ++s)
-          (*pyramid[i])(s, t) =
-              .25f * (Texel(i - 1, 2 * s, 2 * t) +
-                  Texel(i - 1, 2 * s + 1, 2 * t) +
-                  Texel(i - 1, 2 * s, 2 * t + 1) +
-                  Texel(i - 1, 2 * s + 1, 2 * t + 1));
-      }
+          coarser[t * sRes + s] =
+              .25f * (fine_texel(2 * s, 2 * t) +
+                  fine_texel(2 * s + 1, 2 * t) +
+                  fine_texel(2 * s, 2 * t + 1) +
+                  fine_texel(2 * s + 1, 2 * t + 1));
+      }, tRes);
+      if (i == 1) resampled_image.reset();
+      fine_res = Point2i(sRes, tRes);
+      store(i, levels, fine_res, coarser.get());
+      std::swap(finer, coarser);
+      level = finer.get();
     }
   }
 
+  explicit MIPMap(TextureCache::Texture *tex)
+    : cached(tex), wrap_mode(tex->WrapMode()), format(TexelFormat::kFloat) {}
+
   Vector3 Lookup(const Point2f &st, Float width = 0.f) const {
+    static const auto filtered_lookup = MIN_CPU_DISPATCH(&MIPMap::FilteredLookup);
+    if (!cached) return (this->*filtered_lookup)(level_resolution, nullptr, st, width);
+    // One Prepare and one guard cover every texel of the filtered lookup
+    TextureCache::Get().Prepare(cached);
+    TextureCache::ReadGuard guard;
+    return (this->*filtered_lookup)(cached->LevelResolution(), cached, st, width);
+  }
+
+  int Width() const { return Resolutions()[0][0]; }
+  int Height() const { return Resolutions()[0][1]; }
+  int Levels() const { return Resolutions().size(); }
+ private:
+  const std::vector<Point2i> &Resolutions() const {
+    if (!cached) return level_resolution;
+    TextureCache::Get().Prepare(cached);
+    return cached->LevelResolution();
+  }
+
+  // res are the level resolutions, tex the prepared cached texture read under the caller's ReadGuard
+  // or nullptr for the in memory pyramids
+  MIN_FORCE_INLINE Vector3 Texel(const std::vector<Point2i> &res, TextureCache::Texture *tex, int level,
+                                 int s, int t) const {
+    MIN_ASSERT(level < res.size());
+    if (!WrapCoordinates(res[level], s, t)) return Vector3(0.f);
+    if (tex) return TextureCache::Get().Texel(tex, level, s, t);
+    switch (format) {
+      case TexelFormat::kRGB8: return (*pyramid8[level])(s, t).Decode(false);
+      case TexelFormat::kSRGB8: return (*pyramid8[level])(s, t).Decode(true);
+      case TexelFormat::kHalf: return (*pyramid16[level])(s, t).Decode();
+      default: return (*pyramid[level])(s, t);
+    }
+  }
+
+  MIN_FORCE_INLINE Vector3 LookupLevels(const std::vector<Point2i> &res, TextureCache::Texture *tex,
+                                        const Point2f &st, Float width) const {
+    int levels = res.size();
     // Compute MIPMap level for trilinear filtering
-    Float level = Levels() - 1 + Log2(std::max(width, (Float)1e-8));
+    Float level = levels - 1 + Log2(std::max(width, (Float)1e-8));
 
     // Perform trilinear interpolation at appropriate MIPMap level
     if (level < 0)
-      return Triangle(0, st);
-    else if (level >= Levels() - 1)
-      return Texel(Levels() - 1, 0, 0);
+      return Triangle(res, tex, 0, st);
+    else if (level >= levels - 1)
+      return Texel(res, tex, levels - 1, 0, 0);
     else {
       int iLevel = std::floor(level);
       Float delta = level - iLevel;
-      return Lerp(delta, Triangle(iLevel, st), Triangle(iLevel + 1, st));
+      return Lerp(delta, Triangle(res, tex, iLevel, st), Triangle(res, tex, iLevel + 1, st));
     }
   }
 
-  const Vector3 &Texel(int level, int s, int t) const {
-    MIN_ASSERT(level < pyramid.size());
-    const BlockedArray<Vector3> &l = *pyramid[level];
-    // Compute texel $(s,t)$ accounting for boundary conditions
+  MIN_CPU_KERNEL(Vector3, FilteredLookup,
+                 (const std::vector<Point2i> &res, TextureCache::Texture *tex, const Point2f &st, Float width) const,
+                 LookupLevels(res, tex, st, width))
+
+  bool WrapCoordinates(const Point2i &res, int &s, int &t) const {
+    return WrapCoordinates(wrap_mode, res, s, t);
+  }
+
+  // Applies the wrap mode to (s, t), false if the texel lies outside a black border
+  static bool WrapCoordinates(ImageWrapMode wrap_mode, const Point2i &res, int &s, int &t) {
     switch (wrap_mode) {
       case ImageWrapMode::kRepeat:
-        s = Mod(s, l.uSize());
-        t = Mod(t, l.vSize());
+        s = Mod(s, res[0]);
+        t = Mod(t, res[1]);
         break;
       case ImageWrapMode::kClamp:
-        s = Clamp(s, 0, l.uSize() - 1);
-        t = Clamp(t, 0, l.vSize() - 1);
+        s = Clamp(s, 0, res[0] - 1);
+        t = Clamp(t, 0, res[1] - 1);
+        break;
+      case ImageWrapMode::kBlack:
+        if (s < 0 || s >= res[0] || t < 0 || t >= res[1]) return false;
         break;
-      case ImageWrapMode::kBlack: {
-        static const Vector3 black = Vector3(0.f);
-        if (s < 0 || s >= (int)l.uSize() || t < 0 || t >= (int)l.vSize())
-          return black;
+      case ImageWrapMode::kOctahedral:
+        // Crossing an edge mirrors the other coordinate
+        if (s < 0) {
+          s = -s - 1;
+          t = res[1] - 1 - t;
+        } else if (s >= res[0]) {
+          s = 2 * res[0] - 1 - s;
+          t = res[1] - 1 - t;
+        }
+        if (t < 0) {
+          s = res[0] - 1 - s;
+          t = -t - 1;
+        } else if (t >= res[1]) {
+          s = res[0] - 1 - s;
+          t = 2 * res[1] - 1 - t;
+        }
+        s = Clamp(s, 0, res[0] - 1);
+        t = Clamp(t, 0, res[1] - 1);
+        break;
+    }
+    return true;
+  }
+
+  // Converts a linear full precision level to the storage format
+  void StoreLevel(int i, const Vector3 *data) {
+    int sRes = level_resolution[i][0], tRes = level_resolution[i][1];
+    switch (format) {
+      case TexelFormat::kRGB8:
+      case TexelFormat::kSRGB8: {
+        bool srgb = format == TexelFormat::kSRGB8;
+        pyramid8[i].reset(new BlockedArray<TexelRGB8>(sRes, tRes));
+        ParallelFor([&](int64_t t) {
+          for (int s = 0; s < sRes; ++s) (*pyramid8[i])(s, t).Encode(data[t * sRes + s], srgb);
+        }, tRes);
         break;
       }
+      case TexelFormat::kHalf:
+        pyramid16[i].reset(new BlockedArray<TexelHalf>(sRes, tRes));
+        ParallelFor([&](int64_t t) {
+          for (int s = 0; s < sRes; ++s) (*pyramid16[i])(s, t).Encode(data[t * sRes + s]);
+        }, tRes);
+        break;
+      default:
+        pyramid[i].reset(new BlockedArray<Vector3>(sRes, tRes));
+        ParallelFor([&](int64_t t) {
+          for (int s = 0; s < sRes; ++s) (*pyramid[i])(s, t) = data[t * sRes + s];
+        }, tRes);
     }
-    return l(s, t);
   }
-  int Width() const { return resolution[0]; }
-  int Height() const { return resolution[1]; }
-  int Levels() const { return pyramid.size(); }
- private:
-  Float Lanczos(Float x, Float tau = 2.0f) {
+
+  static Float Lanczos(Float x, Float tau = 2.0f) {
     x = std::abs(x);
     if (x < 1e-5f) return 1;
     if (x > 1.f) return 0;
@@ -196,19 +322,20 @@ class MIPMap {
     return s * lanczos;
   }
 
-  Vector3 Triangle(int level, const Point2f &st) const {
-    level = Clamp(level, 0, Levels() - 1);
-    Float s = st[0] * pyramid[level]->uSize() - 0.5f;
-    Float t = st[1] * pyramid[level]->vSize() - 0.5f;
+  MIN_FORCE_INLINE Vector3 Triangle(const std::vector<Point2i> &res, TextureCache::Texture *tex, int level,
+                                    const Point2f &st) const {
+    level = Clamp(level, 0, int(res.size()) - 1);
+    Float s = st[0] * res[level][0] - 0.5f;
+    Float t = st[1] * res[level][1] - 0.5f;
     int s0 = std::floor(s), t0 = std::floor(t);
     Float ds = s - s0, dt = t - t0;
-    return (1 - ds) * (1 - dt) * Texel(level, s0, t0) +
-        (1 - ds) * dt * Texel(level, s0, t0 + 1) +
-        ds * (1 - dt) * Texel(level, s0 + 1, t0) +
-        ds * dt * Texel(level, s0 + 1, t0 + 1);
+    return (1 - ds) * (1 - dt) * Texel(res, tex, level, s0, t0) +
+        (1 - ds) * dt * Texel(res, tex, level, s0, t0 + 1) +
+        ds * (1 - dt) * Texel(res, tex, level, s0 + 1, t0) +
+        ds * dt * Texel(res, tex, level, s0 + 1, t0 + 1);
   }
 
-  std::unique_ptr<ResampleWeight[]> ResampleWeights(int oldRes, int newRes) {
+  static std::unique_ptr<ResampleWeight[]> ResampleWeights(int oldRes, int newRes) {
     MIN_ASSERT(newRes >= oldRes);
     std::unique_ptr<ResampleWeight[]> wt(new ResampleWeight[newRes]);
     Float filterwidth = 2.f;
@@ -0,0 +1,46 @@
+#pragma once
+
+#include "defs.h"
+#include <mutex>
+#include <unordered_map>
+
+namespace min {
+
+// Scene wide store of immutable resources loaded from files. Entries are keyed by the resolved path
+// and every load parameter that changes the result, and stay shared while anything references them.
+template <typename T>
+class ResourceCache {
+ public:
+  static ResourceCache &Get() {
+    static ResourceCache cache;
+    return cache;
+  }
+
+  // create() runs once per key while the previous result is alive, loads are serialized
+  template <typename Create>
+  std::shared_ptr<const T> GetOrCreate(const std::string &key, Create &&create) {
+    std::lock_guard<std::mutex> lock(mutex);
+    std::weak_ptr<const T> &entry = entries[key];
+    if (std::shared_ptr<const T> resource = entry.lock()) {
+      MIN_DEBUG("Reusing {}", key);
+      return resource;
+    }
+    std::shared_ptr<const T> resource = create();
+    entry = resource;
+    return resource;
+  }
+
+ private:
+  ResourceCache() = default;
+  std::mutex mutex;
+  std::unordered_map<std::string, std::weak_ptr<const T>> entries;
+};
+
+template <typename... Params>
+std::string ResourceKey(const fs::path &path, const Params &...params) {
+  std::string key = fs::absolute(path).lexically_normal().string();
+  ((key += fmt::format("|{}", params)), ...);
+  return key;
+}
+
+}
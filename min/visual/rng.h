@@ -2,6 +2,10 @@
 
 #include <cstdint>
 #include <limits>
+#include <algorithm>
+#if defined(__AVX2__)
+#include <immintrin.h>
+#endif
 
 #define PCG32_DEFAULT_STATE  0x853c49e6748fea9bULL
 #define PCG32_DEFAULT_STREAM 0xda3e39cb94b95bdbULL
@@ -9,8 +13,23 @@
 
 namespace min {
 
+// 64 bit finalizer, scatters every input bit over the output
+inline uint64_t MixBits(uint64_t v) {
+  v ^= (v >> 31);
+  v *= 0x7fb5d329728ea185ULL;
+  v ^= (v >> 27);
+  v *= 0x81dadef4bc2dd44dULL;
+  v ^= (v >> 33);
+  return v;
+}
+
+inline uint64_t Hash(uint64_t a, uint64_t b, uint64_t c = 0) {
+  return MixBits(a + MixBits(b + MixBits(c + 0x9e3779b97f4a7c15ULL)));
+}
+
 // https://en.wikipedia.org/wiki/Permuted_congruential_generator
 class Rng {
+  friend class Rng8;
  private:
   uint64_t state;
   uint64_t inc;
@@ -45,12 +64,108 @@ class Rng {
     pcg32();
   }
 
+  // Stream selected by sequence, e.g. one per pixel, with seed as the PCG initial state
+  void SetSequence(uint64_t sequence, uint64_t seed = PCG32_DEFAULT_STATE) {
+    Seed(seed, sequence);
+  }
+
+  // Jumps delta steps in O(log delta), negative deltas go backwards (Brown, "Random number generation
+  // with arbitrary strides")
+  void Advance(int64_t idelta) {
+    state = AdvanceState(state, inc, uint64_t(idelta));
+  }
+
+  static uint64_t AdvanceState(uint64_t state, uint64_t inc, uint64_t delta) {
+    uint64_t cur_mult = PCG32_MULT, cur_plus = inc, acc_mult = 1u, acc_plus = 0u;
+    while (delta > 0) {
+      if (delta & 1U) {
+        acc_mult *= cur_mult;
+        acc_plus = acc_plus * cur_mult + cur_plus;
+      }
+      cur_plus = (cur_mult + 1) * cur_plus;
+      cur_mult *= cur_mult;
+      delta >>= 1U;
+    }
+    return acc_mult * state + acc_plus;
+  }
+
   uint32_t UniformUInt32() {
     return pcg32();
   }
 
+  // In [0, 1), 1 is not reachable
   float UniformFloat() {
-    return float(UniformUInt32()) / std::numeric_limits<uint32_t>::max();
+    return std::min(float(UniformUInt32()) * 0x1p-32f, 0x1.fffffep-1f);
+  }
+};
+
+// Eight PCG32 streams stepped in lockstep for bulk consumers of random numbers, AVX2 when available
+class Rng8 {
+ public:
+  static constexpr int kLanes = 8;
+
+  Rng8() { Seed(PCG32_DEFAULT_STATE, 0); }
+  Rng8(uint64_t initstate, uint64_t stream) { Seed(initstate, stream); }
+
+  // Lane i follows the scalar Rng seeded with (initstate, 8 * stream + i)
+  void Seed(uint64_t initstate, uint64_t stream) {
+    for (int i = 0; i < kLanes; ++i) {
+      Rng lane(initstate, stream * kLanes + i);
+      state[i] = lane.state;
+      inc[i] = lane.inc;
+    }
   }
+
+  void Advance(int64_t delta) {
+    for (int i = 0; i < kLanes; ++i) state[i] = Rng::AdvanceState(state[i], inc[i], uint64_t(delta));
+  }
+
+  void UniformUInt32(uint32_t out[kLanes]) {
+#if defined(__AVX2__)
+    const __m256i mult = _mm256_set1_epi64x(int64_t(PCG32_MULT));
+    const __m256i low_halves = _mm256_setr_epi32(0, 2, 4, 6, 1, 3, 5, 7);
+    for (int h = 0; h < kLanes; h += 4) {
+      __m256i x = _mm256_load_si256(reinterpret_cast<const __m256i *>(&state[h]));
+      __m256i increment = _mm256_load_si256(reinterpret_cast<const __m256i *>(&inc[h]));
+      // 64 bit product from 32 bit multiplies, the high cross terms only reach the upper half
+      __m256i cross = _mm256_add_epi64(_mm256_mul_epu32(_mm256_srli_epi64(x, 32), mult),
+                                       _mm256_mul_epu32(x, _mm256_srli_epi64(mult, 32)));
+      __m256i product = _mm256_add_epi64(_mm256_mul_epu32(x, mult), _mm256_slli_epi64(cross, 32));
+      _mm256_store_si256(reinterpret_cast<__m256i *>(&state[h]), _mm256_add_epi64(product, increment));
+      // Output permutation on the low 32 bits of every 64 bit lane
+      __m256i xs = _mm256_srli_epi64(_mm256_xor_si256(x, _mm256_srli_epi64(x, 18)), 27);
+      __m256i count = _mm256_srli_epi64(x, 59);
+      __m256i left = _mm256_and_si256(_mm256_sub_epi32(_mm256_set1_epi32(32), count), _mm256_set1_epi32(31));
+      __m256i rotated = _mm256_or_si256(_mm256_srlv_epi32(xs, count), _mm256_sllv_epi32(xs, left));
+      _mm_storeu_si128(reinterpret_cast<__m128i *>(&out[h]),
+                       _mm256_castsi256_si128(_mm256_permutevar8x32_epi32(rotated, low_halves)));
+    }
+#else
+    uint64_t x[kLanes];
+    for (int i = 0; i < kLanes; ++i) {
+      x[i] = state[i];
+      state[i] = x[i] * PCG32_MULT + inc[i];
+    }
+    for (int i = 0; i < kLanes; ++i) {
+      uint32_t xs = uint32_t((x[i] ^ (x[i] >> 18U)) >> 27U);
+      uint32_t count = uint32_t(x[i] >> 59U);
+      out[i] = (xs >> count) | (xs << ((32U - count) & 31U));
+    }
+#endif
+  }
+
+  // n values in [0, 1), lanes are interleaved
+  void UniformFloats(float *out, int n) {
+    uint32_t bits[kLanes];
+    for (int i = 0; i < n; i += kLanes) {
+      UniformUInt32(bits);
+      int m = std::min(kLanes, n - i);
+      for (int j = 0; j < m; ++j) out[i + j] = std::min(float(bits[j]) * 0x1p-32f, 0x1.fffffep-1f);
+    }
+  }
+
+ private:
+  alignas(64) uint64_t state[kLanes];
+  alignas(64) uint64_t inc[kLanes];
 };
 }
\ No newline at end of file
@@ -4,11 +4,21 @@
 
 namespace min {
 
+// Both pixel coordinates in one hash key
+inline uint64_t PackPixel(const Point2i &p) {
+  return (uint64_t(uint32_t(p.x)) << 32U) | uint32_t(p.y);
+}
+
 class Sampler : public Unit {
  public:
-  virtual void StartPixel(const Point2i &p) = 0;
+  // Restarts at dimension 0 of the given sample, values only depend on the pixel, index and seed
+  virtual void StartPixelSample(const Point2i &p, int sample_index) = 0;
   virtual Float Get1D() = 0;
   virtual Point2f Get2D() = 0;
+  // n consecutive 2D samples, bulk consumers let implementations batch the generation
+  virtual void Get2DArray(Point2f *u, int n) {
+    for (int i = 0; i < n; ++i) u[i] = Get2D();
+  }
   virtual std::unique_ptr<Sampler> Clone() = 0;
   int64_t spp;
 };
@@ -1,6 +1,7 @@
 #pragma once
 
 #include "defs.h"
+#include <min/math/fastmath.h>
 
 namespace min {
 
@@ -15,7 +16,9 @@ inline Point2f ConcentricSampleDisk(const Point2f &u) {
     r = u_offset.y;
     theta = kPiOver2 - kPiOver4 * (u_offset.x / u_offset.y);
   }
-  return r * Point2f(std::cos(theta), std::sin(theta));
+  Float sin_theta, cos_theta;
+  MathSinCos(theta, &sin_theta, &cos_theta);
+  return r * Point2f(cos_theta, sin_theta);
 }
 
 inline Vector3f CosineSampleHemisphere(const Point2f &u) {
@@ -29,6 +32,57 @@ inline Point2f UniformSampleTriangle(const Point2f &u) {
   return Point2f(1 - su0, u[1] * su0);
 }
 
+inline Vector3f UniformSampleSphere(const Point2f &u) {
+  Float z = 1 - 2 * u[0];
+  Float r = std::sqrt(std::max((Float)0, (Float)1 - z * z));
+  Float sin_phi, cos_phi;
+  MathSinCos(2 * kPi * u[1], &sin_phi, &cos_phi);
+  return Vector3f(r * cos_phi, r * sin_phi, z);
+}
+
+// Clarberg's equal-area octahedral mapping from [0, 1]^2 to the unit sphere
+inline Vector3f EqualAreaSquareToSphere(const Point2f &p) {
+  Float u = 2 * p.x - 1, v = 2 * p.y - 1;
+  Float up = std::abs(u), vp = std::abs(v);
+  Float signed_distance = 1 - (up + vp);
+  Float r = 1 - std::abs(signed_distance);
+  Float phi = (r == 0 ? 1 : (vp - up) / r + 1) * kPiOver4;
+  Float z = std::copysign(1 - r * r, signed_distance);
+  Float sin_phi, cos_phi;
+  MathSinCos(phi, &sin_phi, &cos_phi);
+  cos_phi = std::copysign(cos_phi, u);
+  sin_phi = std::copysign(sin_phi, v);
+  Float scale = r * SafeSqrt(2 - r * r);
+  return Vector3f(cos_phi * scale, sin_phi * scale, z);
+}
+
+// Inverse of EqualAreaSquareToSphere, atan is a polynomial fit so no trigonometry is evaluated
+inline Point2f EqualAreaSphereToSquare(const Vector3f &d) {
+  Float x = std::abs(d.x), y = std::abs(d.y), z = std::abs(d.z);
+  Float r = SafeSqrt(1 - z);
+  Float a = std::max(x, y), b = std::min(x, y);
+  b = a == 0 ? 0 : b / a;
+  // 2 / pi * atan(b) on [0, 1]
+  Float phi = 0.406758566246788489601959989e-5f + b * (0.636226545274016134946890922156f +
+      b * (0.61572017898280213493197203466e-2f + b * (-0.247333733281268944196501420480f +
+      b * (0.881770664775316294736387951347e-1f + b * (0.419038818029165735901852432784e-1f +
+      b * -0.251390972343483509333252996350e-1f)))));
+  if (x < y) phi = 1 - phi;
+  Float v = phi * r, u = r - v;
+  if (d.z < 0) {
+    std::swap(u, v);
+    u = 1 - u;
+    v = 1 - v;
+  }
+  u = std::copysign(u, d.x);
+  v = std::copysign(v, d.y);
+  return Point2f(0.5f * (u + 1), 0.5f * (v + 1));
+}
+
+inline Float UniformConePdf(Float cos_theta_max) {
+  return 1 / (2 * kPi * (1 - cos_theta_max));
+}
+
 inline Float PowerHeuristic(int nf, Float fpdf, int ng, Float gpdf) {
   Float f = nf * fpdf, g = ng * gpdf;
   return (f * f) / (f * f + g * g);
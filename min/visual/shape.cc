@@ -9,9 +9,16 @@ Float Shape::Pdf(const Intersection &ref, const Vector3 &wi) const {
     if (!Intersect(ray, isect_light)) {
       return 0;
     }
-    Float pdf = (ref.p - isect_light.p).LengthSquared() / (std::abs(Dot(isect_light.geo_frame.n, -wi)) * Area());
-    if (std::isinf(pdf)) pdf = 0.0f;
-    return pdf;
+    return Pdf(ref, isect_light);
+}
+
+Float Shape::Pdf(const Intersection &ref, const SurfaceIntersection &isect) const {
+  Vector3 wi = isect.p - ref.p;
+  Float dist2 = wi.LengthSquared();
+  if (dist2 == 0) return 0;
+  Float pdf = dist2 / (AbsDot(isect.geo_frame.n, -wi / std::sqrt(dist2)) * Area());
+  if (std::isinf(pdf)) pdf = 0.0f;
+  return pdf;
 }
 
 }
@@ -28,7 +28,13 @@ class Shape : public Unit {
   virtual bool IntersectP(const Ray &ray) const = 0;
   virtual Float Area() const = 0;
   virtual void Sample(const Point2f& u, SurfaceSample &sample) const = 0;
+  // Uniform point on the surface, only p and normal are filled
+  virtual void SamplePosition(const Point2f &u, SurfaceSample &sample) const { Sample(u, sample); }
   virtual Float Pdf(const Intersection &ref, const Vector3 &wi) const;
+  // Solid angle density of Sample for a direction whose hit on this shape is already known
+  virtual Float Pdf(const Intersection &ref, const SurfaceIntersection &isect) const;
+  // Cone bounding the geometric normals of the surface
+  virtual DirectionCone NormalBounds() const { return DirectionCone::EntireSphere(); }
 };
 MIN_INTERFACE(Shape)
 
@@ -10,5 +10,9 @@ inline bool IsBlack(const Spectrum &s) {
   return !(s.x != 0.0 || s.y != 0.0 || s.z != 0.0);
 }
 
+inline Float Luminance(const Spectrum &s) {
+  return 0.212671f * s.x + 0.715160f * s.y + 0.072169f * s.z;
+}
+
 }
 
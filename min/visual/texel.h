@@ -0,0 +1,100 @@
+#pragma once
+
+#include "defs.h"
+#include <cstring>
+
+namespace min {
+
+// kOctahedral mirrors across the edges of an equal-area octahedral sphere map
+enum ImageWrapMode { kRepeat, kBlack, kClamp, kOctahedral};
+
+// Storage format of MIPMap texels, chosen from the source image
+enum class TexelFormat {
+  kRGB8,   // 8 bit linear
+  kSRGB8,  // 8 bit sRGB encoded
+  kHalf,   // 16 bit float, HDR
+  kFloat
+};
+
+// Round to nearest even, overflow goes to infinity
+inline uint16_t FloatToHalf(float ff) {
+  const uint32_t f32infty = 255U << 23U;
+  const uint32_t f16max = (127U + 16U) << 23U;
+  const uint32_t denorm_magic = ((127U - 15U) + (23U - 10U) + 1U) << 23U;
+  uint32_t f = FloatToBits(ff);
+  uint32_t sign = f & 0x80000000U;
+  f ^= sign;
+  uint16_t o;
+  if (f >= f16max) {
+    o = f > f32infty ? 0x7e00 : 0x7c00;
+  } else if (f < (113U << 23U)) {
+    // Denormal, let the fpu do the rounding
+    o = uint16_t(FloatToBits(BitsToFloat(f) + BitsToFloat(denorm_magic)) - denorm_magic);
+  } else {
+    uint32_t mant_odd = (f >> 13U) & 1U;
+    f += ((15U - 127U) << 23U) + 0xfffU;
+    f += mant_odd;
+    o = uint16_t(f >> 13U);
+  }
+  return o | uint16_t(sign >> 16U);
+}
+
+inline float HalfToFloat(uint16_t h) {
+  const uint32_t shifted_exp = 0x7c00U << 13U;
+  uint32_t o = (h & 0x7fffU) << 13U;
+  uint32_t exp = shifted_exp & o;
+  o += (127U - 15U) << 23U;
+  if (exp == shifted_exp) {
+    // Inf or NaN
+    o += (128U - 16U) << 23U;
+  } else if (exp == 0) {
+    // Zero or denormal, renormalize
+    o += 1U << 23U;
+    o = FloatToBits(BitsToFloat(o) - BitsToFloat(113U << 23U));
+  }
+  return BitsToFloat(o | ((h & 0x8000U) << 16U));
+}
+
+// Decoding tables for 8 bit channels
+struct Texel8LUT {
+  float linear[256], srgb[256];
+  Texel8LUT() {
+    for (int i = 0; i < 256; ++i) {
+      linear[i] = i / 255.f;
+      srgb[i] = InverseGammaCorrect(i / 255.f);
+    }
+  }
+};
+
+inline const Texel8LUT &GetTexel8LUT() {
+  static const Texel8LUT lut;
+  return lut;
+}
+
+struct TexelRGB8 {
+  uint8_t v[3];
+  TexelRGB8() : v{0, 0, 0} {}
+  static uint8_t Quantize(Float x) {
+    return (uint8_t)Clamp((int)std::round(x * 255.f), 0, 255);
+  }
+  void Encode(const Vector3 &c, bool srgb) {
+    for (int i = 0; i < 3; ++i) v[i] = Quantize(srgb ? GammaCorrect(c[i]) : c[i]);
+  }
+  Vector3 Decode(bool srgb) const {
+    const float *table = srgb ? GetTexel8LUT().srgb : GetTexel8LUT().linear;
+    return Vector3(table[v[0]], table[v[1]], table[v[2]]);
+  }
+};
+
+struct TexelHalf {
+  uint16_t v[3];
+  TexelHalf() : v{0, 0, 0} {}
+  void Encode(const Vector3 &c) {
+    for (int i = 0; i < 3; ++i) v[i] = FloatToHalf(c[i]);
+  }
+  Vector3 Decode() const {
+    return Vector3(HalfToFloat(v[0]), HalfToFloat(v[1]), HalfToFloat(v[2]));
+  }
+};
+
+}
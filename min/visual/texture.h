@@ -9,11 +9,19 @@ struct ShadingPoint {
   Point2 texcoords;
   Normal3 ng;
   Normal3 ns;
+  // Screen-space footprint of texcoords, zero when the ray carries no differentials
+  Float dudx = 0, dvdx = 0, dudy = 0, dvdy = 0;
 };
 
 class Texture : public Unit {
  public:
   virtual Spectrum Evaluate(const ShadingPoint &sp) const = 0;
+  // Average value over the texture domain
+  virtual Spectrum Average() const {
+    ShadingPoint sp;
+    sp.texcoords = Point2(0.5f, 0.5f);
+    return Evaluate(sp);
+  }
 };
 MIN_INTERFACE(Texture)
 
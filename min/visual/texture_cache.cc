@@ -0,0 +1,196 @@
+#include "texture_cache.h"
+#include "image.h"
+#include "mipmap.h"
+
+namespace min {
+
+static size_t TexelBytes(TexelFormat format) {
+  switch (format) {
+    case TexelFormat::kRGB8:
+    case TexelFormat::kSRGB8: return sizeof(TexelRGB8);
+    case TexelFormat::kHalf: return sizeof(TexelHalf);
+    default: return 3 * sizeof(Float);
+  }
+}
+
+TextureCache::~TextureCache() {
+  for (auto &tex : textures) {
+    if (tex->scratch.is_open()) tex->scratch.close();
+    if (!tex->scratch_filename.empty()) {
+      std::error_code ec;
+      fs::remove(tex->scratch_filename, ec);
+    }
+    for (int i = 0; i < tex->tile_count; ++i) delete tex->tiles[i].load();
+  }
+  for (Tile *tile : retired) delete tile;
+}
+
+void TextureCache::SetBudget(size_t bytes) {
+  std::lock_guard<std::mutex> lock(mutex);
+  budget = bytes;
+  EvictLocked(nullptr);
+}
+
+TextureCache::Texture *TextureCache::AddTexture(const std::string &filename, const ImageOptions &options) {
+  std::lock_guard<std::mutex> lock(mutex);
+  textures.push_back(std::make_unique<Texture>(filename, options));
+  return textures.back().get();
+}
+
+void TextureCache::Build(Texture *tex) {
+  Point2i resolution;
+  TexelFormat format = TexelFormat::kFloat;
+  std::unique_ptr<Vector3[]> texels = ReadImage(tex->filename, resolution.x, resolution.y, &format);
+  if (!texels) {
+    MIN_WARN("Creating a constant {} texture to replace \"{}\".", tex->options.fallback, tex->filename);
+    resolution = Point2i(1, 1);
+    texels.reset(new Vector3[1]);
+    texels[0] = Vector3(tex->options.fallback);
+    format = TexelFormat::kFloat;
+  }
+  if (tex->options.flip_y) {
+    for (int y = 0; y < resolution.y / 2; y++) {
+      for (int x = 0; x < resolution.x; x++) {
+        int o1 = y * resolution.x + x;
+        int o2 = (resolution.y - 1 - y) * resolution.x + x;
+        std::swap(texels[o1], texels[o2]);
+      }
+    }
+  }
+  if (tex->options.gamma) {
+    for (int i = 0; i < resolution.x * resolution.y; i++)
+      for (int j = 0; j < 3; j++) texels[i][j] = InverseGammaCorrect(texels[i][j]);
+    // 8 bit sources decoded with gamma are stored sRGB encoded, which round-trips exactly
+    if (format == TexelFormat::kRGB8) format = TexelFormat::kSRGB8;
+  }
+  tex->format = format;
+
+  // Tiles are laid out level by level, row major, edge tiles padded to full size. Each level is written
+  // as soon as it is filtered, so no more than the decoded image and two levels are ever in memory.
+  size_t texel_bytes = TexelBytes(format), tile_bytes = kTileSize * kTileSize * texel_bytes;
+  tex->scratch_filename = (fs::temp_directory_path() /
+      fmt::format("min_texture_{:x}_{:x}.tiles", std::hash<std::string>()(tex->filename), uintptr_t(tex))).string();
+  std::ofstream out(tex->scratch_filename, std::ios::binary | std::ios::trunc);
+  std::unique_ptr<uint8_t[]> buffer(new uint8_t[tile_bytes]);
+  tex->tile_count = 0;
+  MIPMap::BuildLevels(resolution, texels.get(), tex->options.wrap_mode,
+                      [&](int level, int levels, const Point2i &res, const Vector3 *data) {
+    // The decoded image was only needed to filter level 1
+    if (level == 1) texels.reset();
+    Point2i tiles((res.x + kTileSize - 1) / kTileSize, (res.y + kTileSize - 1) / kTileSize);
+    tex->level_resolution.push_back(res);
+    tex->level_tiles.push_back(tiles);
+    tex->level_first_tile.push_back(tex->tile_count);
+    tex->tile_count += tiles.x * tiles.y;
+    for (int ty = 0; ty < tiles.y; ++ty) {
+      for (int tx = 0; tx < tiles.x; ++tx) {
+        std::memset(buffer.get(), 0, tile_bytes);
+        for (int y = 0; y < kTileSize && ty * kTileSize + y < res.y; ++y) {
+          for (int x = 0; x < kTileSize && tx * kTileSize + x < res.x; ++x) {
+            const Vector3 &v = data[(ty * kTileSize + y) * res.x + tx * kTileSize + x];
+            uint8_t *dst = buffer.get() + (y * kTileSize + x) * texel_bytes;
+            switch (format) {
+              case TexelFormat::kRGB8:
+              case TexelFormat::kSRGB8: {
+                TexelRGB8 texel;
+                texel.Encode(v, format == TexelFormat::kSRGB8);
+                std::memcpy(dst, &texel, texel_bytes);
+                break;
+              }
+              case TexelFormat::kHalf: {
+                TexelHalf texel;
+                texel.Encode(v);
+                std::memcpy(dst, &texel, texel_bytes);
+                break;
+              }
+              default: {
+                Float rgb[3] = {v[0], v[1], v[2]};
+                std::memcpy(dst, rgb, texel_bytes);
+              }
+            }
+          }
+        }
+        out.write(reinterpret_cast<const char *>(buffer.get()), tile_bytes);
+      }
+    }
+  });
+  tex->tiles.reset(new std::atomic<Tile *>[tex->tile_count]);
+  for (int i = 0; i < tex->tile_count; ++i) tex->tiles[i].store(nullptr);
+  out.close();
+  if (!out) MIN_ERROR("Unable to write texture tiles to \"{}\"", tex->scratch_filename);
+  tex->scratch.open(tex->scratch_filename, std::ios::binary);
+  MIN_INFO("Prepared texture {} ({} tiles, {} MB)", tex->filename, tex->tile_count,
+           tex->tile_count * tile_bytes / (1 << 20));
+}
+
+TextureCache::Tile *TextureCache::LoadTile(Texture *tex, int index) {
+  std::lock_guard<std::mutex> scratch_lock(tex->scratch_mutex);
+  if (Tile *tile = tex->tiles[index].load()) return tile;
+  auto *tile = new Tile;
+  tile->bytes = kTileSize * kTileSize * TexelBytes(tex->format);
+  tile->texels.reset(new uint8_t[tile->bytes]);
+  tile->slot = &tex->tiles[index];
+  tex->scratch.seekg(std::streamoff(index) * tile->bytes);
+  tex->scratch.read(reinterpret_cast<char *>(tile->texels.get()), tile->bytes);
+  if (!tex->scratch) {
+    MIN_WARN("Failed to read tile {} of \"{}\"", index, tex->filename);
+    tex->scratch.clear();
+    std::memset(tile->texels.get(), 0, tile->bytes);
+  }
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    resident.push_back(tile);
+    resident_bytes += tile->bytes;
+    EvictLocked(tile);
+    ReclaimLocked();
+  }
+  tex->tiles[index].store(tile);
+  return tile;
+}
+
+void TextureCache::EvictLocked(const Tile *keep) {
+  bool evicted = false;
+  // Every pass clears reference bits, so a victim is found within two passes
+  while (resident_bytes > budget && resident.size() > 1) {
+    if (clock_hand >= resident.size()) clock_hand = 0;
+    Tile *tile = resident[clock_hand];
+    if (tile == keep || tile->referenced.exchange(false, std::memory_order_relaxed)) {
+      ++clock_hand;
+      continue;
+    }
+    tile->slot->store(nullptr);
+    tile->retire_epoch = epoch.load();
+    resident[clock_hand] = resident.back();
+    resident.pop_back();
+    resident_bytes -= tile->bytes;
+    retired.push_back(tile);
+    evicted = true;
+  }
+  if (evicted) epoch.fetch_add(1);
+}
+
+void TextureCache::ReclaimLocked() {
+  if (retired.empty()) return;
+  uint64_t oldest = std::numeric_limits<uint64_t>::max();
+  for (const auto &slot : epoch_slots) {
+    uint64_t e = slot->load();
+    if (e != 0) oldest = std::min(oldest, e);
+  }
+  // Readers that entered at or before the retiring epoch may still hold the tile
+  auto freed = std::partition(retired.begin(), retired.end(),
+                              [&](const Tile *tile) { return tile->retire_epoch >= oldest; });
+  for (auto it = freed; it != retired.end(); ++it) delete *it;
+  retired.erase(freed, retired.end());
+}
+
+std::atomic<uint64_t> &TextureCache::EpochSlot() {
+  thread_local std::atomic<uint64_t> *slot = nullptr;
+  if (!slot) {
+    std::lock_guard<std::mutex> lock(mutex);
+    epoch_slots.push_back(std::make_unique<std::atomic<uint64_t>>(0));
+    slot = epoch_slots.back().get();
+  }
+  return *slot;
+}
+
+}
@@ -0,0 +1,128 @@
+#pragma once
+
+#include "defs.h"
+#include "texel.h"
+#include <atomic>
+#include <mutex>
+#include <fstream>
+
+namespace min {
+
+// Global cache streaming MIPMap levels of image files in fixed size tiles under a memory budget.
+// A texture is prepared on first use: decoded and filtered level by level, every level written tile by
+// tile to a scratch file as soon as it is filtered. Tiles are read back on demand and evicted with the
+// CLOCK approximation of LRU.
+// Hits only touch atomics, evicted tiles are freed once no reader may still hold them.
+class TextureCache {
+ public:
+  static constexpr int kTileSize = 64;
+
+  struct ImageOptions {
+    ImageWrapMode wrap_mode = ImageWrapMode::kRepeat;
+    // Decode 8 bit sources as sRGB
+    bool gamma = false;
+    bool flip_y = false;
+    // Constant value standing in for an image that fails to decode
+    Float fallback = 0.5f;
+  };
+
+  struct Tile {
+    std::unique_ptr<uint8_t[]> texels;
+    size_t bytes = 0;
+    std::atomic<bool> referenced{true};
+    std::atomic<Tile *> *slot = nullptr;
+    uint64_t retire_epoch = 0;
+  };
+
+  class Texture {
+    friend class TextureCache;
+    std::string filename;
+    ImageOptions options;
+    std::once_flag prepared;
+    TexelFormat format = TexelFormat::kFloat;
+    std::vector<Point2i> level_resolution, level_tiles;
+    std::vector<int> level_first_tile;
+    int tile_count = 0;
+    std::unique_ptr<std::atomic<Tile *>[]> tiles;
+    std::string scratch_filename;
+    std::ifstream scratch;
+    std::mutex scratch_mutex;
+   public:
+    Texture(const std::string &filename, const ImageOptions &options) : filename(filename), options(options) {}
+    // Valid once TextureCache::Prepare returned
+    const std::vector<Point2i> &LevelResolution() const { return level_resolution; }
+    ImageWrapMode WrapMode() const { return options.wrap_mode; }
+  };
+
+  // Keeps the tiles read by this thread alive, guards nest
+  class ReadGuard {
+    std::atomic<uint64_t> &slot;
+   public:
+    ReadGuard() : slot(Get().EpochSlot()) {
+      if (Depth()++ == 0) slot.store(Get().epoch.load());
+    }
+    ~ReadGuard() {
+      if (--Depth() == 0) slot.store(0, std::memory_order_release);
+    }
+    static int &Depth() {
+      thread_local int depth = 0;
+      return depth;
+    }
+  };
+
+  static TextureCache &Get() {
+    static TextureCache cache;
+    return cache;
+  }
+  ~TextureCache();
+
+  void SetBudget(size_t bytes);
+  size_t Budget() const { return budget; }
+
+  // Registers an image file, nothing is read before the first lookup
+  Texture *AddTexture(const std::string &filename, const ImageOptions &options);
+
+  void Prepare(Texture *tex) {
+    std::call_once(tex->prepared, [&] { Build(tex); });
+  }
+
+  // (s, t) must be inside the level and the calling thread must hold a ReadGuard
+  Vector3 Texel(Texture *tex, int level, int s, int t) {
+    int index = tex->level_first_tile[level] + (t / kTileSize) * tex->level_tiles[level].x + s / kTileSize;
+    Tile *tile = tex->tiles[index].load();
+    if (!tile) tile = LoadTile(tex, index);
+    if (!tile->referenced.load(std::memory_order_relaxed))
+      tile->referenced.store(true, std::memory_order_relaxed);
+    int offset = (t % kTileSize) * kTileSize + s % kTileSize;
+    switch (tex->format) {
+      case TexelFormat::kRGB8: return reinterpret_cast<const TexelRGB8 *>(tile->texels.get())[offset].Decode(false);
+      case TexelFormat::kSRGB8: return reinterpret_cast<const TexelRGB8 *>(tile->texels.get())[offset].Decode(true);
+      case TexelFormat::kHalf: return reinterpret_cast<const TexelHalf *>(tile->texels.get())[offset].Decode();
+      default: {
+        Vector3 v;
+        std::memcpy(&v[0], tile->texels.get() + offset * 3 * sizeof(Float), 3 * sizeof(Float));
+        return v;
+      }
+    }
+  }
+
+ private:
+  TextureCache() = default;
+  void Build(Texture *tex);
+  Tile *LoadTile(Texture *tex, int index);
+  void EvictLocked(const Tile *keep);
+  void ReclaimLocked();
+  std::atomic<uint64_t> &EpochSlot();
+
+  std::mutex mutex;
+  std::vector<std::unique_ptr<Texture>> textures;
+  size_t budget = size_t(1024) << 20U;
+  // Resident tiles in clock order, retired tiles wait for the readers that may hold them
+  std::vector<Tile *> resident, retired;
+  size_t clock_hand = 0, resident_bytes = 0;
+  // Readers publish the epoch they entered at, 0 when outside a ReadGuard
+  std::atomic<uint64_t> epoch{1};
+  std::vector<std::unique_ptr<std::atomic<uint64_t>>> epoch_slots;
+};
+
+}
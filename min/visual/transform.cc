@@ -0,0 +1,86 @@
+#include "transform.h"
+#include <min/common/parallel.h>
+
+namespace min {
+
+namespace {
+
+// Elements per task when a batch is split over threads
+constexpr int64_t kBatchGrain = 4096;
+
+// Runs func(begin, end) over [0, n), in parallel once there is more than one grain of work
+template <typename F>
+void ForBatches(int64_t n, F func) {
+  if (n <= kBatchGrain) {
+    func(int64_t(0), n);
+    return;
+  }
+  ParallelFor([&](int64_t t) {
+    func(t * kBatchGrain, std::min(n, (t + 1) * kBatchGrain));
+  }, (n + kBatchGrain - 1) / kBatchGrain);
+}
+
+#if defined(MIN_SIMD_SSE)
+// r = c0 * x + c1 * y + c2 * z (+ c3), summed in the order of the scalar transforms so results match
+// them bit for bit. The w lane of the output is cleared
+template <bool kTranslate>
+MIN_FORCE_INLINE void Combine(const Vector3f *in, Vector3f *out, int64_t begin, int64_t end,
+                              const __m128 c[4], bool divide) {
+  const __m128 xyz_mask = _mm_castsi128_ps(_mm_setr_epi32(-1, -1, -1, 0));
+  for (int64_t i = begin; i < end; ++i) {
+    __m128 p = in[i].v;
+    __m128 r = _mm_add_ps(_mm_mul_ps(c[0], _mm_shuffle_ps(p, p, _MM_SHUFFLE(0, 0, 0, 0))),
+                          _mm_mul_ps(c[1], _mm_shuffle_ps(p, p, _MM_SHUFFLE(1, 1, 1, 1))));
+    r = _mm_add_ps(r, _mm_mul_ps(c[2], _mm_shuffle_ps(p, p, _MM_SHUFFLE(2, 2, 2, 2))));
+    if constexpr (kTranslate) {
+      r = _mm_add_ps(r, c[3]);
+      if (divide) r = _mm_div_ps(r, _mm_shuffle_ps(r, r, _MM_SHUFFLE(3, 3, 3, 3)));
+    }
+    out[i].v = _mm_and_ps(r, xyz_mask);
+  }
+}
+#endif
+
+}
+
+void Transform::ToPoints(const Point3f *in, Point3f *out, int64_t n) const {
+#if defined(MIN_SIMD_SSE)
+  // Columns of m, the w lane carries the homogeneous coordinate
+  __m128 c[4];
+  for (int j = 0; j < 4; ++j) c[j] = _mm_setr_ps(m[0][j], m[1][j], m[2][j], m[3][j]);
+  // Projective points divide even when w is 1, which is exact
+  bool divide = !affine;
+  ForBatches(n, [&](int64_t begin, int64_t end) { Combine<true>(in, out, begin, end, c, divide); });
+#else
+  ForBatches(n, [&](int64_t begin, int64_t end) {
+    for (int64_t i = begin; i < end; ++i) out[i] = ToPoint(in[i]);
+  });
+#endif
+}
+
+void Transform::ToVectors(const Vector3f *in, Vector3f *out, int64_t n) const {
+#if defined(MIN_SIMD_SSE)
+  __m128 c[4];
+  for (int j = 0; j < 3; ++j) c[j] = _mm_setr_ps(m[0][j], m[1][j], m[2][j], 0.f);
+  ForBatches(n, [&](int64_t begin, int64_t end) { Combine<false>(in, out, begin, end, c, false); });
+#else
+  ForBatches(n, [&](int64_t begin, int64_t end) {
+    for (int64_t i = begin; i < end; ++i) out[i] = ToVector(in[i]);
+  });
+#endif
+}
+
+void Transform::ToNormals(const Normal3f *in, Normal3f *out, int64_t n) const {
+#if defined(MIN_SIMD_SSE)
+  // Normals go through the inverse transpose, whose columns are the rows of inv
+  __m128 c[4];
+  for (int j = 0; j < 3; ++j) c[j] = inv.d[j].v;
+  ForBatches(n, [&](int64_t begin, int64_t end) { Combine<false>(in, out, begin, end, c, false); });
+#else
+  ForBatches(n, [&](int64_t begin, int64_t end) {
+    for (int64_t i = begin; i < end; ++i) out[i] = ToNormal(in[i]);
+  });
+#endif
+}
+
+}
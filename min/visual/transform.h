@@ -7,16 +7,24 @@ namespace min {
 
 class Transform {
   Matrix4f m, inv;
+  // Last row is (0, 0, 0, 1), points need no homogeneous divide
+  bool affine;
+
+  static bool IsAffine(const Matrix4f &mat) {
+    return mat[3][0] == 0.f && mat[3][1] == 0.f && mat[3][2] == 0.f && mat[3][3] == 1.f;
+  }
  public:
   Transform() {
     m = Matrix4f::Identidy();
     inv = Matrix4f::Identidy();
+    affine = true;
   }
   Transform(const Matrix4f &mat) {
     m = mat;
     inv = Inverse(mat);
+    affine = IsAffine(m);
   }
-  Transform(const Matrix4f &m, const Matrix4f &inv) : m(m), inv(inv) {}
+  Transform(const Matrix4f &m, const Matrix4f &inv) : m(m), inv(inv), affine(IsAffine(m)) {}
 
   friend Transform Inverse(const Transform &t) {
     return Transform(t.inv, t.m);
@@ -54,6 +62,7 @@ class Transform {
         m[3][0] == 0.f && m[3][1] == 0.f && m[3][2] == 0.f &&
         m[3][3] == 1.f);
   }
+  bool IsAffine() const { return affine; }
   const Matrix4f &GetMatrix() const { return m; }
   const Matrix4f &GetInverseMatrix() const { return inv; }
 
@@ -63,6 +72,7 @@ class Transform {
     T xp = m[0][0] * x + m[0][1] * y + m[0][2] * z + m[0][3];
     T yp = m[1][0] * x + m[1][1] * y + m[1][2] * z + m[1][3];
     T zp = m[2][0] * x + m[2][1] * y + m[2][2] * z + m[2][3];
+    if (affine) return TPoint3<T>(xp, yp, zp);
     T wp = m[3][0] * x + m[3][1] * y + m[3][2] * z + m[3][3];
     if (wp == 1)
       return TPoint3<T>(xp, yp, zp);
@@ -87,6 +97,18 @@ class Transform {
   }
 
   MIN_FORCE_INLINE Bounds3f ToBounds3(const Bounds3f &b) const {
+    if (affine) {
+      // Arvo, "Transforming axis-aligned bounding boxes", each output axis takes the smaller and larger
+      // product per input axis instead of transforming all eight corners
+      Bounds3f ret(Point3f(m[0][3], m[1][3], m[2][3]));
+      for (int i = 0; i < 3; ++i)
+        for (int j = 0; j < 3; ++j) {
+          Float a = m[i][j] * b.pmin[j], c = m[i][j] * b.pmax[j];
+          ret.pmin[i] += std::min(a, c);
+          ret.pmax[i] += std::max(a, c);
+        }
+      return ret;
+    }
     const Transform &M = *this;
     Bounds3f ret(M.ToPoint(Point3f(b.pmin.x, b.pmin.y, b.pmin.z)));
     ret = Union(ret, M.ToPoint(Point3f(b.pmax.x, b.pmin.y, b.pmin.z)));
@@ -99,6 +121,10 @@ class Transform {
     return ret;
   }
 
+  // Batched versions over contiguous arrays, out may alias in. Large arrays are split over threads
+  void ToPoints(const Point3f *in, Point3f *out, int64_t n) const;
+  void ToVectors(const Vector3f *in, Vector3f *out, int64_t n) const;
+  void ToNormals(const Normal3f *in, Normal3f *out, int64_t n) const;
 };
 
 MIN_FORCE_INLINE Transform Translate(const Vector3f &delta) {
@@ -164,6 +190,7 @@ MIN_FORCE_INLINE Transform Rotate(Float theta, const Vector3f &axis) {
   m[2][1] = a.y * a.z * (1 - cosTheta) + a.x * sinTheta;
   m[2][2] = a.z * a.z + (1 - a.z * a.z) * cosTheta;
   m[2][3] = 0;
+  m[3][3] = 1;
   return Transform(m, Transpose(m));
 }
 